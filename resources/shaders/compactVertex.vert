@@ -0,0 +1,82 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable 
+
+
+
+layout(location = 0) in vec4 inPosition; //Normalized in the bounds of the mesh
+layout(location = 1) in vec2 inNormal; //Octahedral encoding
+layout(location = 2) in vec2 inTexCoord;
+
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 vertexPos;
+layout(location = 3) out vec3 lightDir;
+layout(location = 4) out vec3 camDir;
+
+layout(binding = 0) uniform CameraData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 inverseView;
+    vec4 eyePosition;
+    vec4 lightPosition;
+}camera;
+
+//Computed on the CPU once per object, the draws give the index of their object as first instance
+struct ObjectData
+{
+    mat4 model;
+    mat4 normal;
+    mat4 mvp;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+};
+
+layout(push_constant) uniform QuantizationConstants
+{
+    vec4 offset;
+    vec4 scale;
+}bounds;
+
+out gl_PerVertex{
+    vec4 gl_Position;
+    float gl_PointSize;
+};
+
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    //The lower half of the octahedron is folded on the corners of the square
+    if(normal.z < 0.0)
+    {
+        vec2 signs = vec2(encoded.x >= 0.0 ? 1.0 : -1.0, encoded.y >= 0.0 ? 1.0 : -1.0);
+        normal.xy = (1.0 - abs(encoded.yx)) * signs;
+    }
+
+    return normalize(normal);
+}
+
+void main()
+{
+    vec3 position = bounds.offset.xyz + inPosition.xyz * bounds.scale.xyz;
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_PointSize = 1.0; //Only read when drawing the point clouds
+    gl_Position = object.mvp * vec4(position, 1.0);
+
+    vec4 worldPos = object.model * vec4(position, 1.0);
+    mat3 normalMatrix = mat3(object.normal); //Prevent Normal deformation from non uniform model matrice
+
+
+    lightDir = camera.lightPosition.xyz - worldPos.xyz;
+    camDir = camera.eyePosition.xyz - worldPos.xyz;
+    fragNormal = normalize(normalMatrix * decodeOctahedral(inNormal));
+    fragTexCoord = inTexCoord;
+
+
+}
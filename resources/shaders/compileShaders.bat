@@ -1,2 +1,3 @@
 C:/VulkanSDK/1.1.82.1/Bin/glslangValidator.exe -V vertex.vert
-C:/VulkanSDK/1.1.82.1/Bin/glslangValidator.exe -V fragment.frag
\ No newline at end of file
+C:/VulkanSDK/1.1.82.1/Bin/glslangValidator.exe -V fragment.frag
+C:/VulkanSDK/1.1.82.1/Bin/glslangValidator.exe -V compactVertex.vert -o compactVert.spv
\ No newline at end of file
@@ -1,7 +1,16 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable 
 
-layout(binding = 1) uniform sampler2D texSampler;
+layout(set = 1, binding = 0) uniform sampler2D texSampler;
+
+//Set by the point pipelines, the point clouds have no face to get a normal from
+layout(constant_id = 0) const bool UNLIT = false;
+
+//After the quantization constants of the compact vertex shader
+layout(push_constant) uniform MaterialConstants
+{
+    layout(offset = 32) vec4 diffuseColor;
+} material;
 
 
 layout(location = 0) in vec3 fragNormal;
@@ -18,7 +27,13 @@ void main()
 {
 
 
-    vec4 albedo = texture(texSampler, fragTexCoord);// vec4(fragTexCoord, 1.0 ,1.0);
+    vec4 albedo = texture(texSampler, fragTexCoord) * material.diffuseColor;// vec4(fragTexCoord, 1.0 ,1.0);
+
+    if(UNLIT)
+    {
+        outColor = vec4(albedo.xyz, 1.0);
+        return;
+    }
 
     vec3 N = normalize(fragNormal);
     vec3 L = normalize(lightDir);
@@ -14,16 +14,31 @@ layout(location = 2) out vec3 vertexPos;
 layout(location = 3) out vec3 lightDir;
 layout(location = 4) out vec3 camDir;
 
-layout(binding = 0) uniform UniformBufferObject
+layout(binding = 0) uniform CameraData
 {
-    mat4 model;
     mat4 view;
     mat4 projection;
-    vec3 lightPos;
-}ubo;
+    mat4 inverseView;
+    vec4 eyePosition;
+    vec4 lightPosition;
+}camera;
+
+//Computed on the CPU once per object, the draws give the index of their object as first instance
+struct ObjectData
+{
+    mat4 model;
+    mat4 normal;
+    mat4 mvp;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+};
 
 out gl_PerVertex{
     vec4 gl_Position;
+    float gl_PointSize;
 };
 
 
@@ -32,14 +47,16 @@ out gl_PerVertex{
 void main()
 {
     //vec3 lightPos = vec3(3.0, 0.0, -1.0);
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_PointSize = 1.0; //Only read when drawing the point clouds
+    gl_Position = object.mvp * vec4(inPosition, 1.0);
 
-    vec4 worldPos = ubo.model * vec4(inPosition, 1.0);
-    mat3 normalMatrix = transpose(inverse(mat3(ubo.model))); //Prevent Normal deformation from non uniform model matrice
+    vec4 worldPos = object.model * vec4(inPosition, 1.0);
+    mat3 normalMatrix = mat3(object.normal); //Prevent Normal deformation from non uniform model matrice
 
 
-    lightDir = ubo.lightPos - worldPos.xyz;
-    camDir = (inverse(ubo.view)*vec4(0.0,0.0,0.0,1.0) - worldPos).xyz;
+    lightDir = camera.lightPosition.xyz - worldPos.xyz;
+    camDir = camera.eyePosition.xyz - worldPos.xyz;
     fragNormal = normalize(normalMatrix * inNormal);
     fragTexCoord = inTexCoord;
 
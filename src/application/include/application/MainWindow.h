@@ -4,7 +4,13 @@
 #include <QVulkanWindow>
 #include <QSlider>
 #include "application/RendererWindow.h"
+#include <QCheckBox>
 #include <QComboBox>
+#include <QDragEnterEvent>
+#include <QDropEvent>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTimer>
 
 class MainWindow : public QWidget
 {
@@ -12,12 +18,28 @@ class MainWindow : public QWidget
 private:
     RendererWindow* renderer_;
     QComboBox* modelSelection_;
+    QProgressBar* loadProgress_;
+    QPushButton* cancelLoad_;
+    //Polls the background loads, the rendering keeps going while a file is imported
+    QTimer loadTimer_;
+
+    static constexpr int LOAD_POLL_INTERVAL_MS = 50;
 
     void refreshModelSelection();
+    // Load the files and the supported files of the directories, all at once
+    void loadPaths(const QStringList& paths);
+
+protected:
+    void dragEnterEvent(QDragEnterEvent* event) override;
+    void dropEvent(QDropEvent* event) override;
 
 protected slots:
-    void loadObjFile();
+    void loadModelFiles();
+    void loadDirectory();
     void changeModelSelected(int index);
+    void updateLoads();
+    void cancelLoads();
+    void setCompactVertices(bool enabled);
 
 
 public:
@@ -2,26 +2,99 @@
 
 #include "renderer/VulkanCore.h"
 #include "renderer/Model.h"
-#include "loader/ObjLoader.h"
+#include "loader/LoaderRegistry.h"
+#include "loader/ThreadPool.h"
+#include <future>
+#include <memory>
+#include <mutex>
+
+/*@brief : Handle on a model loaded in the background by the ModelManager. The progress can be read
+*          from any thread while the load is running. The meshes are streamed in the model as soon
+*          as the loader completes them
+*/
+class ModelLoadTask
+{
+    friend class ModelManager;
+
+private:
+    std::string path_;
+    LoadProgress progress_;
+    std::future<bool> result_;
+
+    //Meshes given by the loader and not added to the model yet
+    std::mutex streamedMeshesMutex_;
+    std::vector<data::MeshPtr> streamedMeshes_;
+    //Index of the model receiving the meshes, created with the first mesh
+    int modelIndex_ = -1;
+    //Set when the task loads again the meshes released by the model, displayed once they are all there
+    bool isReload_ = false;
+
+public:
+    explicit ModelLoadTask(const std::string& path);
+
+    const std::string& getPath() const;
+    uint64_t getTotalBytes() const;
+    uint64_t getParsedBytes() const;
+    uint64_t getMeshCount() const;
+
+    bool isFinished() const;
+    bool isCancelled() const;
+    // The task stops as soon as the loader notices it, the meshes already received are dropped
+    void cancel();
+};
 
 class ModelManager
 {
 protected:
-    ObjLoader loader_;
+    //Files loaded at once, each by its own loader on its own worker
+    static constexpr size_t MAX_CONCURRENT_LOADS = 4;
+
+    LoaderRegistry loaderRegistry_;
 
     renderer::VulkanCore* pCore_;
 
-    std::vector<renderer::Model> models_;
-    renderer::Model* selectedModel_;
-    int selectedModelIndex_;
+    //The selected model is displayed by the core, which keeps a pointer to it
+    std::vector<std::unique_ptr<renderer::Model>> models_;
+    //Index rather than pointer, adding a model may reallocate models_
+    int selectedModelIndex_ = -1;
+    renderer::E_VertexFormat vertexFormat_ = renderer::STANDARD_VERTEX;
+    //Applied to a model once its file is loaded, the models not displayed then take no host memory
+    renderer::E_MeshResidency meshResidency_ = renderer::RELEASE_HOST_MESHES;
+
+    std::vector<std::shared_ptr<ModelLoadTask>> loadTasks_;
+    //Declared last so that the workers are joined before the tasks they fill are destroyed
+    ThreadPool loadPool_;
+
+    std::unique_ptr<renderer::Model> createModel(const std::string& path) const;
+    void removeModel(int index);
+    // Load the released meshes of the model on a background worker, see finishReload
+    void reloadModelAsync(int index);
+    // Display the model if it is still selected, while the task holds its meshes
+    void finishReload(ModelLoadTask& task);
 
 public:
     ModelManager(renderer::VulkanCore* vkCore);
+    ~ModelManager();
 
     void loadNewMesh(const std::string& path);
+    // Load the file on a background worker, the model is filled by updateLoads. Up to
+    // MAX_CONCURRENT_LOADS files are loaded at once, the next ones wait for a worker
+    std::shared_ptr<ModelLoadTask> loadNewMeshAsync(const std::string& path);
+    // Must be called from the thread owning the vulkan core. Add the meshes streamed since the last
+    // call to their model, uploading them if the model is displayed, and remove the models of the
+    // loads that failed. Return true if models were added or removed
+    bool updateLoads();
+    void cancelLoads();
+    const std::vector<std::shared_ptr<ModelLoadTask>>& getLoadTasks() const;
+    const LoaderRegistry& getLoaderRegistry() const;
+
+    // The model is displayed right away if its meshes are in host memory. Else they are loaded again by
+    // a background task and the model is displayed by updateLoads, nothing is displayed meanwhile
     void setSelectedModel(int index);
+    // Vertex format of the models created by the next loads
+    void setVertexFormat(renderer::E_VertexFormat format);
 
-    const std::vector<renderer::Model>& getModels()const;
+    const std::vector<std::unique_ptr<renderer::Model>>& getModels()const;
     const renderer::Model& getSelectedModel()const;
     int getSelectedModelIndex()const;
 
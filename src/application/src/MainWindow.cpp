@@ -1,34 +1,162 @@
 #include "application/MainWindow.h"
 #include <QLayout>
 #include <QLabel>
+#include <QDir>
 #include <QFileDialog>
-#include <QPushButton>
+#include <QFileInfo>
+#include <QMimeData>
+#include <QSignalBlocker>
+#include <QUrl>
 
 void MainWindow::refreshModelSelection()
 {
-    modelSelection_->clear();
+    {
+        //Filling the list would select its first model, creating it for nothing
+        QSignalBlocker blocker(modelSelection_);
+        modelSelection_->clear();
+
+        for(const std::unique_ptr<renderer::Model>& pModel : renderer_->getModelManager().getModels())
+        {
+            modelSelection_->addItem(QString::fromStdString(pModel->getName()));
+        }
+
+        modelSelection_->setCurrentIndex(modelSelection_->count() - 1);
+    }
+
+    changeModelSelected(modelSelection_->currentIndex());
+}
+
+void MainWindow::loadPaths(const QStringList& paths)
+{
+    ModelManager& modelManager = renderer_->getModelManager();
+    bool isLoading = false;
+
+    for(const QString& path : paths)
+    {
+        QFileInfo info(path);
+
+        if(!info.isDir())
+        {
+            modelManager.loadNewMeshAsync(path.toStdString());
+            isLoading = true;
+            continue;
+        }
+
+        //Only the files of the directory itself, with the extension of a supported format
+        for(const QFileInfo& file : QDir(path).entryInfoList(QDir::Files, QDir::Name))
+        {
+            std::string filePath = file.absoluteFilePath().toStdString();
+
+            if(modelManager.getLoaderRegistry().hasKnownExtension(filePath))
+            {
+                modelManager.loadNewMeshAsync(filePath);
+                isLoading = true;
+            }
+        }
+    }
+
+    if(isLoading)
+    {
+        updateLoads();
+        loadTimer_.start(LOAD_POLL_INTERVAL_MS);
+    }
+}
+
+void MainWindow::loadModelFiles()
+{
+    QString patterns;
+
+    for(const std::string& extension : renderer_->getModelManager().getLoaderRegistry().getExtensions())
+    {
+        patterns += QString(patterns.isEmpty() ? "*.%1" : " *.%1").arg(QString::fromStdString(extension));
+    }
+
+    QStringList filePaths = QFileDialog::getOpenFileNames(this, "Select the models to load", "./",
+                            QString("Models (%1);;All Files (*)").arg(patterns));
+    loadPaths(filePaths);
+}
+
+void MainWindow::loadDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, "Select the directory to load", "./");
+
+    if(directory.size())
+    {
+        loadPaths(QStringList(directory));
+    }
+}
+
+void MainWindow::dragEnterEvent(QDragEnterEvent* event)
+{
+    if(event->mimeData()->hasUrls())
+    {
+        event->acceptProposedAction();
+    }
+}
+
+void MainWindow::dropEvent(QDropEvent* event)
+{
+    QStringList paths;
 
-    for(auto model : renderer_->getModelManager().getModels())
+    for(const QUrl& url : event->mimeData()->urls())
     {
-        modelSelection_->addItem(QString::fromStdString(model.getName()));
+        if(url.isLocalFile())
+        {
+            paths.append(url.toLocalFile());
+        }
     }
 
-    modelSelection_->setCurrentIndex(renderer_->getModelManager().getModels().size() - 1);
+    loadPaths(paths);
+    event->acceptProposedAction();
 }
 
-void MainWindow::loadObjFile()
+void MainWindow::updateLoads()
 {
-    QString filePath = QFileDialog::getOpenFileName(this, "Select the obj file to load", "./",
-                       "Obj File (*.obj)");
+    ModelManager& modelManager = renderer_->getModelManager();
+
+    //The meshes are uploaded to the device here, on the thread owning the vulkan core
+    if(modelManager.updateLoads())
+    {
+        refreshModelSelection();
+    }
+
+    const std::vector<std::shared_ptr<ModelLoadTask>>& tasks = modelManager.getLoadTasks();
 
-    if(filePath.size())
+    if(tasks.empty())
     {
-        renderer_->getModelManager().loadNewMesh(filePath.toStdString());
-        renderer_->resetCamera();
+        loadTimer_.stop();
+        loadProgress_->hide();
+        cancelLoad_->hide();
+        return;
+    }
+
+    uint64_t totalBytes = 0;
+    uint64_t parsedBytes = 0;
+    uint64_t meshCount = 0;
+
+    for(const std::shared_ptr<ModelLoadTask>& task : tasks)
+    {
+        totalBytes += task->getTotalBytes();
+        parsedBytes += task->getParsedBytes();
+        meshCount += task->getMeshCount();
     }
 
-    refreshModelSelection();
+    //Per mille of the bytes, a file of several GB doesn't fit the int range of the bar
+    loadProgress_->setValue(totalBytes ? static_cast<int>(parsedBytes * 1000 / totalBytes) : 0);
+    loadProgress_->setFormat(QString("Loading %1 file(s) : %p% (%2 meshes)").arg(tasks.size()).arg(
+                                 meshCount));
+    loadProgress_->show();
+    cancelLoad_->show();
+}
 
+void MainWindow::cancelLoads()
+{
+    renderer_->getModelManager().cancelLoads();
+}
+
+void MainWindow::setCompactVertices(bool enabled)
+{
+    renderer_->getModelManager().setVertexFormat(enabled ? renderer::COMPACT_VERTEX : renderer::STANDARD_VERTEX);
 }
 
 void MainWindow::changeModelSelected(int index)
@@ -36,8 +164,21 @@ void MainWindow::changeModelSelected(int index)
     if(index < 0) // no index selected
         return;
 
-    renderer_->getModelManager().setSelectedModel(index);
+    ModelManager& modelManager = renderer_->getModelManager();
+
+    if(index == modelManager.getSelectedModelIndex())
+    {
+        return;
+    }
+
+    modelManager.setSelectedModel(index);
     renderer_->resetCamera();
+
+    //The meshes released by the model are loaded again in the background, displayed by updateLoads
+    if(!modelManager.getLoadTasks().empty() && !loadTimer_.isActive())
+    {
+        loadTimer_.start(LOAD_POLL_INTERVAL_MS);
+    }
 }
 
 MainWindow::MainWindow(QWindow* vulkanWindow):
@@ -63,22 +204,45 @@ MainWindow::MainWindow(QWindow* vulkanWindow):
     browse->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     optionLayout->addWidget(browse);
 
+    QPushButton* browseDirectory = new QPushButton("Load directory...", this);
+    browseDirectory->setToolTip("Load every supported file of a directory at once, files can also be dropped here");
+    browseDirectory->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    optionLayout->addWidget(browseDirectory);
+
+    QCheckBox* compactVertices = new QCheckBox("Compact vertices", this);
+    compactVertices->setToolTip("Store the vertices of the next models in 16 bytes instead of 32");
+    optionLayout->addWidget(compactVertices);
+
     modelSelection_ = new QComboBox(this);
     optionLayout->addWidget(modelSelection_);
 
+    loadProgress_ = new QProgressBar(this);
+    loadProgress_->setRange(0, 1000);
+    loadProgress_->hide();
+    optionLayout->addWidget(loadProgress_);
+
+    cancelLoad_ = new QPushButton("Cancel loading", this);
+    cancelLoad_->hide();
+    optionLayout->addWidget(cancelLoad_);
+
     layout->addLayout(optionLayout, 0, 1, Qt::AlignCenter);
     layout->setColumnStretch(1, 1);
 
-    connect(browse, SIGNAL(clicked()), this, SLOT(loadObjFile()));
+    connect(browse, SIGNAL(clicked()), this, SLOT(loadModelFiles()));
+    connect(browseDirectory, SIGNAL(clicked()), this, SLOT(loadDirectory()));
     connect(fullScreen, SIGNAL(clicked()), renderer_, SLOT(setFullscreen()));
     connect(modelSelection_, SIGNAL(currentIndexChanged(int)), this, SLOT(changeModelSelected(int)));
+    connect(cancelLoad_, SIGNAL(clicked()), this, SLOT(cancelLoads()));
+    connect(compactVertices, SIGNAL(toggled(bool)), this, SLOT(setCompactVertices(bool)));
+    connect(&loadTimer_, SIGNAL(timeout()), this, SLOT(updateLoads()));
 
     setLayout(layout);
+    setAcceptDrops(true);
 }
 
 
 
 MainWindow::~MainWindow()
 {
-
+    loadTimer_.stop();
 }
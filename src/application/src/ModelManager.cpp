@@ -1,46 +1,371 @@
 #include "application/ModelManager.h"
+#include <chrono>
+#include <plog/Log.h>
+
+ModelLoadTask::ModelLoadTask(const std::string& path):
+    path_(path)
+{
+
+}
+
+const std::string& ModelLoadTask::getPath() const
+{
+    return path_;
+}
+
+uint64_t ModelLoadTask::getTotalBytes() const
+{
+    return progress_.totalBytes;
+}
+
+uint64_t ModelLoadTask::getParsedBytes() const
+{
+    return progress_.parsedBytes;
+}
+
+uint64_t ModelLoadTask::getMeshCount() const
+{
+    return progress_.meshCount;
+}
+
+bool ModelLoadTask::isFinished() const
+{
+    return result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool ModelLoadTask::isCancelled() const
+{
+    return progress_.cancelled;
+}
+
+void ModelLoadTask::cancel()
+{
+    progress_.cancelled = true;
+}
 
 ModelManager::ModelManager(renderer::VulkanCore* vkCore):
+    loaderRegistry_(LoaderRegistry::createDefault()),
     pCore_(vkCore),
-    selectedModel_(nullptr)
+    loadPool_(MAX_CONCURRENT_LOADS)
 {
 
 }
 
-void ModelManager::loadNewMesh(const std::string& path)
+ModelManager::~ModelManager()
 {
-    renderer::Model model(pCore_);
+    //The pool runs the pending loads before joining, they return as soon as they see the cancellation
+    cancelLoads();
+    //The core outlives the manager, it must not keep a pointer on a destroyed model
+    pCore_->setModel(nullptr);
+}
 
-    std::vector<data::Mesh> scene;
-    loader_.load(path, scene);
-    model.assignMesh(scene);
+std::unique_ptr<renderer::Model> ModelManager::createModel(const std::string& path) const
+{
+    std::unique_ptr<renderer::Model> pModel(new renderer::Model(pCore_));
 
     std::string fileName = path.substr(path.find_last_of("/") + 1);
-    model.setName(fileName);
+    pModel->setName(fileName);
+    pModel->setVertexFormat(vertexFormat_);
+
+    //Read from the cooked cache when the format has one, else parsed again from the file
+    const LoaderRegistry* pRegistry = &loaderRegistry_;
+    pModel->setMeshSource([pRegistry, path](std::vector<data::MeshPtr>& meshes)
+    {
+        std::unique_ptr<Loader> pLoader = pRegistry->createLoader(path);
+        return pLoader && pLoader->load(path, meshes);
+    });
+
+    return pModel;
+}
 
-    models_.push_back(model);
+void ModelManager::removeModel(int index)
+{
+    if(selectedModelIndex_ == index)
+    {
+        pCore_->setModel(nullptr);
+    }
+
+    models_.erase(models_.begin() + index);
+
+    for(const std::shared_ptr<ModelLoadTask>& task : loadTasks_)
+    {
+        if(task->modelIndex_ > index)
+        {
+            task->modelIndex_--;
+        }
+        else if(task->modelIndex_ == index && task->isReload_)
+        {
+            task->cancel();
+            task->modelIndex_ = -1;
+        }
+    }
+
+    if(selectedModelIndex_ > index)
+    {
+        selectedModelIndex_--;
+    }
+    else if(selectedModelIndex_ == index)
+    {
+        selectedModelIndex_ = -1;
+    }
+}
+
+void ModelManager::loadNewMesh(const std::string& path)
+{
+    loadNewMeshAsync(path)->result_.wait();
+    updateLoads();
 }
 
-const std::vector<renderer::Model>& ModelManager::getModels() const
+std::shared_ptr<ModelLoadTask> ModelManager::loadNewMeshAsync(const std::string& path)
+{
+    std::shared_ptr<ModelLoadTask> task = std::make_shared<ModelLoadTask>(path);
+    ModelLoadTask* pTask = task.get();
+
+    task->result_ = loadPool_.enqueue([this, pTask]()
+    {
+        if(pTask->isCancelled())
+        {
+            return false;
+        }
+
+        Loader::MeshCallback onMesh = [this, pTask](const data::MeshPtr & mesh)
+        {
+            //Decoded on the texture workers while the file is still loading, uploaded with the mesh
+            pCore_->getTextureCache().prefetch(mesh->material.diffuseTexture);
+
+            std::lock_guard<std::mutex> lock(pTask->streamedMeshesMutex_);
+            pTask->streamedMeshes_.push_back(mesh);
+        };
+
+        //A loader per file, the loads running at once share nothing
+        std::unique_ptr<Loader> pLoader = loaderRegistry_.createLoader(pTask->path_);
+
+        if(!pLoader)
+        {
+            return false;
+        }
+
+        pLoader->setProgress(&pTask->progress_);
+        return pLoader->loadStreaming(pTask->path_, onMesh);
+    });
+
+    loadTasks_.push_back(task);
+    return task;
+}
+
+void ModelManager::reloadModelAsync(int index)
+{
+    for(const std::shared_ptr<ModelLoadTask>& task : loadTasks_)
+    {
+        if(task->isReload_ && task->modelIndex_ == index && !task->isCancelled())
+        {
+            return;
+        }
+    }
+
+    std::shared_ptr<ModelLoadTask> task = std::make_shared<ModelLoadTask>(models_[index]->getName());
+    ModelLoadTask* pTask = task.get();
+    task->modelIndex_ = index;
+    task->isReload_ = true;
+    //A copy, the model may be removed while its meshes are loaded
+    renderer::Model::MeshSource meshSource = models_[index]->getMeshSource();
+
+    task->result_ = loadPool_.enqueue([pTask, meshSource]()
+    {
+        std::vector<data::MeshPtr> meshes;
+
+        if(pTask->isCancelled() || !meshSource || !meshSource(meshes))
+        {
+            return false;
+        }
+
+        pTask->progress_.meshCount = meshes.size();
+        std::lock_guard<std::mutex> lock(pTask->streamedMeshesMutex_);
+        pTask->streamedMeshes_.swap(meshes);
+        return true;
+    });
+
+    loadTasks_.push_back(task);
+}
+
+void ModelManager::finishReload(ModelLoadTask& task)
+{
+    bool loaded = false;
+
+    try
+    {
+        loaded = task.result_.get();
+    }
+    catch(const std::exception& e)
+    {
+        PLOGE << "Loading of " << task.path_ << " failed : " << e.what() << '\n';
+    }
+
+    std::vector<data::MeshPtr> meshes;
+
+    {
+        std::lock_guard<std::mutex> lock(task.streamedMeshesMutex_);
+        meshes.swap(task.streamedMeshes_);
+    }
+
+    //Another model may have been selected meanwhile, the meshes are then released again
+    if(!loaded || task.isCancelled() || task.modelIndex_ < 0 || task.modelIndex_ != selectedModelIndex_)
+    {
+        return;
+    }
+
+    renderer::Model* pModel = models_[task.modelIndex_].get();
+
+    if(pModel->restoreHostMeshes(meshes))
+    {
+        pCore_->setModel(pModel);
+    }
+}
+
+bool ModelManager::updateLoads()
+{
+    bool modelsChanged = false;
+    auto itTask = loadTasks_.begin();
+
+    while(itTask != loadTasks_.end())
+    {
+        ModelLoadTask& task = **itTask;
+        //Checked before taking the meshes, nothing is streamed anymore once the load is finished
+        bool isFinished = task.isFinished();
+
+        if(task.isReload_)
+        {
+            if(isFinished)
+            {
+                finishReload(task);
+                itTask = loadTasks_.erase(itTask);
+            }
+            else
+            {
+                itTask++;
+            }
+
+            continue;
+        }
+        std::vector<data::MeshPtr> meshes;
+
+        {
+            std::lock_guard<std::mutex> lock(task.streamedMeshesMutex_);
+            meshes.swap(task.streamedMeshes_);
+        }
+
+        if(!meshes.empty() && !task.isCancelled())
+        {
+            if(task.modelIndex_ < 0)
+            {
+                models_.push_back(createModel(task.path_));
+                task.modelIndex_ = static_cast<int>(models_.size()) - 1;
+                modelsChanged = true;
+            }
+
+            //The displayed model is the one of the core, the buffers of the meshes streamed since the last
+            //frame are created in one upload
+            if(task.modelIndex_ == selectedModelIndex_)
+            {
+                pCore_->appendMeshesToModel(meshes);
+            }
+            else
+            {
+                models_[task.modelIndex_]->appendMeshes(meshes);
+            }
+        }
+
+        if(!isFinished)
+        {
+            itTask++;
+            continue;
+        }
+
+        bool loaded = false;
+
+        try
+        {
+            loaded = task.result_.get();
+        }
+        catch(const std::exception& e)
+        {
+            PLOGE << "Loading of " << task.path_ << " failed : " << e.what() << '\n';
+        }
+
+        if(task.isCancelled())
+        {
+            PLOGI << "Loading of " << task.path_ << " cancelled" << '\n';
+        }
+
+        //Part of a file is not kept, whatever was already displayed
+        if((!loaded || task.isCancelled()) && task.modelIndex_ >= 0)
+        {
+            removeModel(task.modelIndex_);
+            modelsChanged = true;
+        }
+        else if(task.modelIndex_ >= 0)
+        {
+            //Every mesh is in the model, the source can give them all again
+            models_[task.modelIndex_]->setResidency(meshResidency_);
+        }
+
+        itTask = loadTasks_.erase(itTask);
+    }
+
+    return modelsChanged;
+}
+
+void ModelManager::cancelLoads()
+{
+    for(const std::shared_ptr<ModelLoadTask>& task : loadTasks_)
+    {
+        task->cancel();
+    }
+}
+
+const std::vector<std::shared_ptr<ModelLoadTask>>& ModelManager::getLoadTasks() const
+{
+    return loadTasks_;
+}
+
+const LoaderRegistry& ModelManager::getLoaderRegistry() const
+{
+    return loaderRegistry_;
+}
+
+const std::vector<std::unique_ptr<renderer::Model>>& ModelManager::getModels() const
 {
     return models_;
 }
 
 void ModelManager::setSelectedModel(int index)
 {
-    if(selectedModel_ == &models_[index])
+    if(selectedModelIndex_ == index)
     {
         return;
     }
 
-    selectedModel_ = &models_[index];
-    pCore_->setModel(*selectedModel_);
     selectedModelIndex_ = index;
+
+    //Not loaded again on the thread owning the core, the frames keep being drawn meanwhile
+    if(!models_[index]->hasHostMeshes())
+    {
+        pCore_->setModel(nullptr);
+        reloadModelAsync(index);
+        return;
+    }
+
+    pCore_->setModel(models_[index].get());
+}
+
+void ModelManager::setVertexFormat(renderer::E_VertexFormat format)
+{
+    vertexFormat_ = format;
 }
 
 const renderer::Model& ModelManager::getSelectedModel() const
 {
-    return *selectedModel_;
+    return *models_[selectedModelIndex_];
 }
 
 int ModelManager::getSelectedModelIndex() const
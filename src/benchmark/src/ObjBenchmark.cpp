@@ -0,0 +1,107 @@
+#include "loader/ObjLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <plog/Log.h>
+
+/*@brief : Time the load of an obj file by the native parser with 1, 2, 4... threads, then by tinyobj.
+*          Usage : objBenchmark file.obj [maxThreads] [runs]
+*          The cache, the optimization and the levels of detail are disabled so that mostly the parsing
+*          is measured, the best of the runs is kept for each configuration
+*/
+
+namespace
+{
+
+// Best time in ms of the loads, -1 if one fails
+float timeLoads(ObjLoader& loader, const std::string& path, int runs, size_t& meshCount)
+{
+    float bestTime = -1.0f;
+
+    for(int run = 0; run < runs; run++)
+    {
+        std::vector<data::MeshPtr> scene;
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        if(!loader.load(path, scene))
+        {
+            return -1.0f;
+        }
+
+        float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>
+                         (std::chrono::high_resolution_clock::now() - startTime).count();
+        bestTime = bestTime < 0.0f ? loadTime : std::min(bestTime, loadTime);
+        meshCount = scene.size();
+    }
+
+    return bestTime;
+}
+
+void printRow(const std::string& name, float time, float referenceTime, size_t meshCount)
+{
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << time << " ms" << std::setw(10) << std::setprecision(2)
+              << referenceTime / time << "x" << std::setw(10) << meshCount << " meshes" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage : " << argv[0] << " file.obj [maxThreads] [runs]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    plog::init(plog::warning, "./benchmark_log.txt");
+
+    std::string path = argv[1];
+    size_t maxThreads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    int runs = argc > 3 ? std::atoi(argv[3]) : 3;
+    maxThreads = std::max<size_t>(maxThreads, 1);
+    runs = std::max(runs, 1);
+
+    ObjLoader loader;
+    loader.setCacheEnabled(false);
+    loader.setOptimizationEnabled(false);
+    loader.setLodGenerationEnabled(false);
+
+    size_t meshCount = 0;
+    loader.setParser(TINYOBJ_PARSER);
+    float tinyObjTime = timeLoads(loader, path, runs, meshCount);
+
+    if(tinyObjTime < 0.0f)
+    {
+        std::cerr << "Failed to load " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //Speedups relative to tinyobj
+    printRow("tinyobj", tinyObjTime, tinyObjTime, meshCount);
+    loader.setParser(NATIVE_PARSER);
+
+    for(size_t threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreads))
+    {
+        loader.setThreadCount(threadCount);
+        float nativeTime = timeLoads(loader, path, runs, meshCount);
+
+        if(nativeTime < 0.0f)
+        {
+            std::cerr << "Failed to load " << path << " with " << threadCount << " threads" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        printRow("native x" + std::to_string(threadCount), nativeTime, tinyObjTime, meshCount);
+
+        if(threadCount == maxThreads)
+        {
+            break;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
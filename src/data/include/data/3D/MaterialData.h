@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <string>
+
+namespace data
+{
+
+/*@brief : Material of a mesh as read from its file, the renderer creates the textures it needs from it.
+*          A mesh without material keeps the default values, an empty name and no texture
+*/
+struct MaterialData
+{
+    std::string name;
+    glm::vec3 diffuseColor = glm::vec3(1.0f);
+    //Path of the image, empty if the material has no diffuse texture
+    std::string diffuseTexture;
+};
+
+}
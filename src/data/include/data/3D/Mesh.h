@@ -1,20 +1,44 @@
 #pragma once
 
+#include "data/3D/MaterialData.h"
 #include "data/3D/VertexAttribute.h"
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 
 namespace data
 {
 
+// Meshes with at most this number of vertices have their indices stored on 16 bits by the GPU
+constexpr size_t MAX_SHORT_INDEX_VERTEX_COUNT = 65536;
+
+/*@brief : Coarser version of a mesh, its indices use the vertices of the mesh. error is the distance,
+*          in object space, between the level and the full resolution mesh
+*/
+struct MeshLod
+{
+    std::vector<uint32_t> indices;
+    float error = 0.0f;
+};
 
 struct Mesh
 {
     std::string name;
     std::vector<VertexAttribute> vertices;
     std::vector<uint32_t> indices;
+    //From the finest to the coarsest level, empty if the mesh has no level of detail
+    std::vector<MeshLod> lods;
+    //Material of every face of the mesh
+    MaterialData material;
 
     Mesh() = default;
+
+    // Size in bytes of an index once uploaded, 2 if every vertex can be addressed with 16 bits, else 4
+    uint32_t getIndexSize() const;
 };
 
+// A mesh is immutable once loaded, the loader, the cache and the models share the same arrays
+using MeshPtr = std::shared_ptr<const Mesh>;
+
 }
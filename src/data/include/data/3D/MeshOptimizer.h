@@ -0,0 +1,55 @@
+#pragma once
+
+#include "data/3D/Mesh.h"
+#include <cstdint>
+#include <vector>
+
+namespace data
+{
+
+// Number of entries of the post-transform cache assumed by the optimization and the statistics
+constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+// Memory cache assumed by the vertex fetch statistics
+constexpr uint32_t FETCH_CACHE_LINE_SIZE = 64;
+constexpr uint32_t FETCH_CACHE_SIZE = 16 * 1024;
+
+/*@brief : Efficiency of the post-transform vertex cache for an index buffer, simulated with a FIFO
+*          cache. ACMR is the number of vertices transformed per triangle (3 at worst, close to 0.5
+*          for a regular grid), ATVR the number of transformations per vertex of the mesh (1 at best)
+*/
+struct VertexCacheStats
+{
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+VertexCacheStats analyzeVertexCache(const Mesh& mesh, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+/*@brief : Reorder the triangles of the mesh so that consecutive triangles reuse the vertices still in
+*          the post-transform cache, using Tipsify (Sander, Nehab and Barczak 2007). The algorithm
+*          fans around a vertex, then moves to the neighbour staying the longest in the cache. The
+*          levels of detail of the mesh are reordered too
+*/
+void optimizeVertexCache(Mesh& mesh, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+// Same on a single index buffer referencing vertexCount vertices
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+                         uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+/*@brief : Memory traffic of the vertex fetches of an index buffer, simulated with a FIFO cache of
+*          FETCH_CACHE_SIZE bytes. The overfetch is the ratio between the bytes read and the size of
+*          the vertex buffer (1 at best)
+*/
+struct VertexFetchStats
+{
+    float bytesPerTriangle = 0.0f;
+    float overfetch = 0.0f;
+};
+
+VertexFetchStats analyzeVertexFetch(const Mesh& mesh);
+
+/*@brief : Renumber the vertices in the order the index buffer first uses them so that the fetches
+*          walk the vertex buffer forward. The vertices no index uses are removed, return their number
+*/
+size_t optimizeVertexFetch(Mesh& mesh);
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "data/3D/Mesh.h"
+#include <cstdint>
+#include <vector>
+
+namespace data
+{
+
+// Each level of detail targets this ratio of the triangles of the previous one
+constexpr float LOD_TRIANGLE_RATIO = 0.5f;
+// No level is generated below this number of triangles
+constexpr size_t LOD_MIN_TRIANGLE_COUNT = 256;
+constexpr size_t LOD_MAX_LEVEL_COUNT = 8;
+
+/*@brief : Simplify a triangle list with edge collapses ordered by quadric error (Garland and Heckbert
+*          1997). A collapse merges a vertex into one of its neighbours without moving it, so the result
+*          indexes the same vertices. Vertices shared by a UV or normal seam (several vertices at the
+*          same position) are never collapsed and vertices of an open border only slide along it.
+*          The simplification stops at targetIndexCount or before a collapse moving the surface by more
+*          than targetError. resultError receives the largest distance introduced
+*/
+std::vector<uint32_t> simplifyMesh(const std::vector<VertexAttribute>& vertices,
+                                   const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError,
+                                   float& resultError);
+
+/*@brief : Fill mesh.lods with successive simplifications of the mesh, stopping at
+*          LOD_MIN_TRIANGLE_COUNT triangles or when the simplification doesn't progress anymore
+*/
+void generateLods(Mesh& mesh);
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "data/3D/Mesh.h"
+#include <cstdint>
+#include <functional>
+
+namespace data
+{
+
+// Meshes with more triangles are processed in blocks of this size given to the ParallelFor
+constexpr size_t NORMAL_BLOCK_SIZE = 1 << 16;
+// Crease angle disabling the creases, every vertex gets a smooth normal
+constexpr float NO_CREASE_ANGLE = 3.14159265f;
+
+enum E_NormalWeighting
+{
+    AREA_WEIGHTING, //Each face contributes proportionally to its area
+    ANGLE_WEIGHTING //Each face contributes proportionally to its angle at the vertex, independent of the tessellation
+};
+
+// Call function(idx) for idx in [0, count) and return once all the calls ended, possibly in parallel
+using ParallelFor = std::function<void(size_t count, const std::function<void(size_t idx)>& function)>;
+
+// Return true if no vertex of the mesh has a null normal
+bool hasNormals(const Mesh& mesh);
+
+/*@brief : Give the vertices with a null normal the weighted average of the normals of the faces sharing
+*          their position, whatever the other attributes of the vertices at this position. The normals
+*          already set, e.g. read from the file, are kept. Faces making an angle larger than creaseAngle
+*          (radians) with a face are left out of the normals of its corners, the vertices on a crease
+*          are then split. Every step gathers the contributions over an adjacency list, the blocks of
+*          triangles or positions are independent and given to parallelFor when the mesh has more than
+*          NORMAL_BLOCK_SIZE triangles. A mesh without triangles, a point cloud, is left as it is
+*/
+void generateNormals(Mesh& mesh, float creaseAngle = NO_CREASE_ANGLE, E_NormalWeighting weighting = ANGLE_WEIGHTING,
+                     const ParallelFor& parallelFor = nullptr);
+
+}
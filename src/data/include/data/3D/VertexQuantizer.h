@@ -0,0 +1,42 @@
+#pragma once
+
+#include "data/3D/Mesh.h"
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace data
+{
+
+/*@brief : 16 bytes version of VertexAttribute. The position is stored in 16 bits unsigned normalized
+*          integers relative to the bounds of its mesh (w is unused), the normal is encoded on an
+*          octahedron in two 16 bits signed normalized integers and the texture coordinate in half
+*          floats
+*/
+struct CompactVertexAttribute
+{
+    uint16_t pos[4];
+    int16_t normal[2];
+    uint16_t texCoord[2];
+};
+
+static_assert(sizeof(CompactVertexAttribute) == 16, "CompactVertexAttribute must not contain padding");
+
+// Box the quantized positions are relative to : pos = offset + quantized * scale, quantized in [0, 1]
+struct QuantizationBounds
+{
+    glm::vec3 offset;
+    glm::vec3 scale;
+};
+
+QuantizationBounds computeQuantizationBounds(const std::vector<VertexAttribute>& vertices);
+
+// Normal of unit length mapped to [-1, 1]^2 with an octahedron unfolded on the plane z = 0
+glm::vec2 encodeOctahedral(const glm::vec3& normal);
+glm::vec3 decodeOctahedral(const glm::vec2& encoded);
+
+void quantizeVertices(const std::vector<VertexAttribute>& vertices, const QuantizationBounds& bounds,
+                      std::vector<CompactVertexAttribute>& compactVertices);
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "data/3D/Mesh.h"
+#include <cstdint>
+#include <vector>
+
+namespace data
+{
+
+/*@brief : Indices of the position, the normal and the texture coordinate used by a face corner
+*          A negative index means the attribute is not provided by the file
+*/
+struct VertexKey
+{
+    int32_t vertex;
+    int32_t normal;
+    int32_t texCoord;
+
+    bool operator==(const VertexKey& other) const;
+};
+
+/*@brief : Open addressing hash table (linear probing) associating a face corner to the index of
+*          the vertex already emitted for it, so that shared vertices are stored only once
+*/
+class VertexWelder
+{
+private:
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+    struct Slot
+    {
+        VertexKey key;
+        uint32_t value;
+    };
+
+    std::vector<Slot> slots_;
+    uint32_t mask_ = 0;
+    uint32_t size_ = 0;
+
+    static uint32_t hash(const VertexKey& key);
+    void rehash(size_t capacity);
+
+public:
+    VertexWelder(size_t expectedVertices = 0);
+
+    void reset(size_t expectedVertices);
+
+    // Return the index stored for the key, or store and return candidate if the key is new
+    uint32_t findOrInsert(const VertexKey& key, uint32_t candidate, bool& inserted);
+    uint32_t size() const;
+};
+
+}
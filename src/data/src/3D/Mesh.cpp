@@ -3,4 +3,9 @@
 namespace data
 {
 
+uint32_t Mesh::getIndexSize() const
+{
+    return vertices.size() <= MAX_SHORT_INDEX_VERTEX_COUNT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
 }
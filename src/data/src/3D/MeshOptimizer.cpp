@@ -0,0 +1,259 @@
+#include "data/3D/MeshOptimizer.h"
+#include <vector>
+
+namespace data
+{
+
+namespace
+{
+
+const uint32_t NO_VERTEX = 0xFFFFFFFF;
+
+//Next vertex to fan around : among the vertices of the last fan, the one with triangles left that
+//has been in the cache the longest while still being in it once its triangles are emitted
+uint32_t findNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& liveTriangles,
+                        const std::vector<uint32_t>& timeStamps, uint32_t time, uint32_t cacheSize,
+                        std::vector<uint32_t>& deadEnds, size_t& cursor)
+{
+    uint32_t bestVertex = NO_VERTEX;
+    int64_t bestPriority = -1;
+
+    for(uint32_t vertex : candidates)
+    {
+        if(liveTriangles[vertex] == 0)
+        {
+            continue;
+        }
+
+        int64_t priority = 0;
+        uint32_t age = time - timeStamps[vertex];
+
+        //Each triangle left adds at most 2 vertices to the cache
+        if(age + 2 * liveTriangles[vertex] <= cacheSize)
+        {
+            priority = age;
+        }
+
+        if(priority > bestPriority)
+        {
+            bestPriority = priority;
+            bestVertex = vertex;
+        }
+    }
+
+    if(bestVertex != NO_VERTEX)
+    {
+        return bestVertex;
+    }
+
+    //Dead end : go back to the most recently used vertex that still has triangles
+    while(!deadEnds.empty())
+    {
+        uint32_t vertex = deadEnds.back();
+        deadEnds.pop_back();
+
+        if(liveTriangles[vertex] > 0)
+        {
+            return vertex;
+        }
+    }
+
+    //Otherwise jump to the next vertex in the order of the buffer
+    while(cursor < liveTriangles.size() && liveTriangles[cursor] == 0)
+    {
+        cursor++;
+    }
+
+    return cursor < liveTriangles.size() ? static_cast<uint32_t>(cursor) : NO_VERTEX;
+}
+
+}
+
+VertexCacheStats analyzeVertexCache(const Mesh& mesh, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+
+    if(mesh.indices.size() < 3 || mesh.vertices.empty())
+    {
+        return stats;
+    }
+
+    //A vertex is in the FIFO if fewer than cacheSize vertices were transformed since its own transformation
+    std::vector<uint32_t> timeStamps(mesh.vertices.size(), 0);
+    uint32_t time = cacheSize + 1;
+    size_t transformCount = 0;
+
+    for(uint32_t index : mesh.indices)
+    {
+        if(time - timeStamps[index] > cacheSize)
+        {
+            timeStamps[index] = time++;
+            transformCount++;
+        }
+    }
+
+    stats.acmr = static_cast<float>(transformCount) / (mesh.indices.size() / 3);
+    stats.atvr = static_cast<float>(transformCount) / mesh.vertices.size();
+    return stats;
+}
+
+void optimizeVertexCache(Mesh& mesh, uint32_t cacheSize)
+{
+    optimizeVertexCache(mesh.indices, mesh.vertices.size(), cacheSize);
+
+    for(MeshLod& lod : mesh.lods)
+    {
+        optimizeVertexCache(lod.indices, mesh.vertices.size(), cacheSize);
+    }
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& meshIndices, size_t vertexCount, uint32_t cacheSize)
+{
+    size_t triangleCount = meshIndices.size() / 3;
+
+    if(triangleCount == 0 || meshIndices.size() % 3 != 0)
+    {
+        return;
+    }
+
+    //Triangles using each vertex, stored contiguously vertex after vertex
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+
+    for(uint32_t index : meshIndices)
+    {
+        liveTriangles[index]++;
+    }
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+
+    for(size_t idxVertex = 0; idxVertex < vertexCount; idxVertex++)
+    {
+        offsets[idxVertex + 1] = offsets[idxVertex] + liveTriangles[idxVertex];
+    }
+
+    std::vector<uint32_t> adjacency(meshIndices.size());
+    std::vector<uint32_t> fillOffsets(offsets.begin(), offsets.end() - 1);
+
+    for(size_t idxCorner = 0; idxCorner < meshIndices.size(); idxCorner++)
+    {
+        adjacency[fillOffsets[meshIndices[idxCorner]]++] = static_cast<uint32_t>(idxCorner / 3);
+    }
+
+    std::vector<uint32_t> timeStamps(vertexCount, 0);
+    std::vector<uint8_t> isEmitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> indices;
+    indices.reserve(meshIndices.size());
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+    uint32_t fanVertex = meshIndices[0];
+
+    while(fanVertex != NO_VERTEX)
+    {
+        candidates.clear();
+
+        for(uint32_t idx = offsets[fanVertex]; idx < offsets[fanVertex + 1]; idx++)
+        {
+            uint32_t triangle = adjacency[idx];
+
+            if(isEmitted[triangle])
+            {
+                continue;
+            }
+
+            for(size_t idxCorner = 0; idxCorner < 3; idxCorner++)
+            {
+                uint32_t vertex = meshIndices[triangle * 3 + idxCorner];
+                indices.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+
+                if(time - timeStamps[vertex] > cacheSize)
+                {
+                    timeStamps[vertex] = time++;
+                }
+            }
+
+            isEmitted[triangle] = 1;
+        }
+
+        fanVertex = findNextVertex(candidates, liveTriangles, timeStamps, time, cacheSize, deadEnds, cursor);
+    }
+
+    meshIndices.swap(indices);
+}
+
+VertexFetchStats analyzeVertexFetch(const Mesh& mesh)
+{
+    VertexFetchStats stats;
+
+    if(mesh.indices.size() < 3 || mesh.vertices.empty())
+    {
+        return stats;
+    }
+
+    const size_t vertexSize = sizeof(VertexAttribute);
+    const uint32_t lineCount = FETCH_CACHE_SIZE / FETCH_CACHE_LINE_SIZE;
+    size_t bufferSize = mesh.vertices.size() * vertexSize;
+
+    //Same FIFO model as the post-transform cache, on the cache lines of the vertex buffer
+    std::vector<uint32_t> timeStamps((bufferSize + FETCH_CACHE_LINE_SIZE - 1) / FETCH_CACHE_LINE_SIZE, 0);
+    uint32_t time = lineCount + 1;
+    size_t fetchedLines = 0;
+
+    for(uint32_t index : mesh.indices)
+    {
+        size_t firstLine = index * vertexSize / FETCH_CACHE_LINE_SIZE;
+        size_t lastLine = ((index + 1) * vertexSize - 1) / FETCH_CACHE_LINE_SIZE;
+
+        for(size_t line = firstLine; line <= lastLine; line++)
+        {
+            if(time - timeStamps[line] > lineCount)
+            {
+                timeStamps[line] = time++;
+                fetchedLines++;
+            }
+        }
+    }
+
+    float fetchedBytes = static_cast<float>(fetchedLines) * FETCH_CACHE_LINE_SIZE;
+    stats.bytesPerTriangle = fetchedBytes / (mesh.indices.size() / 3);
+    stats.overfetch = fetchedBytes / bufferSize;
+    return stats;
+}
+
+size_t optimizeVertexFetch(Mesh& mesh)
+{
+    std::vector<uint32_t> remap(mesh.vertices.size(), NO_VERTEX);
+    std::vector<VertexAttribute> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for(uint32_t& index : mesh.indices)
+    {
+        if(remap[index] == NO_VERTEX)
+        {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    //The levels of detail only use vertices of the full mesh
+    for(MeshLod& lod : mesh.lods)
+    {
+        for(uint32_t& index : lod.indices)
+        {
+            index = remap[index];
+        }
+    }
+
+    size_t removed = mesh.vertices.size() - vertices.size();
+    mesh.vertices.swap(vertices);
+    return removed;
+}
+
+}
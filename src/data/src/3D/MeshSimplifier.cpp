@@ -0,0 +1,485 @@
+#include "data/3D/MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <glm/geometric.hpp>
+
+namespace data
+{
+
+namespace
+{
+
+const uint32_t NO_VERTEX = 0xFFFFFFFF;
+//Weight of the planes keeping an open border in place, relative to the planes of its triangles
+const double BORDER_WEIGHT = 10.0;
+//A level removing less than this ratio of the triangles of the previous one is not kept
+const float LOD_MIN_REDUCTION = 0.1f;
+//Cosine of the largest rotation of a triangle normal allowed by a collapse, above it turns into a sliver
+const float MIN_NORMAL_COSINE = 0.5f;
+
+enum E_VertexKind
+{
+    MANIFOLD_VERTEX,
+    BORDER_VERTEX,
+    LOCKED_VERTEX
+};
+
+/*@brief : Sum of squared distances to a set of planes, stored as the symmetric matrix A, the vector b
+*          and the scalar c of p.A.p + 2 b.p + c
+*/
+struct Quadric
+{
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    //Area of the triangles added, the error is the weighted mean of the squared distances
+    double weight = 0.0;
+};
+
+void addPlane(Quadric& quadric, const glm::vec3& normal, double d, double weight)
+{
+    double x = normal.x;
+    double y = normal.y;
+    double z = normal.z;
+
+    quadric.a00 += weight * x * x;
+    quadric.a01 += weight * x * y;
+    quadric.a02 += weight * x * z;
+    quadric.a11 += weight * y * y;
+    quadric.a12 += weight * y * z;
+    quadric.a22 += weight * z * z;
+    quadric.b0 += weight * x * d;
+    quadric.b1 += weight * y * d;
+    quadric.b2 += weight * z * d;
+    quadric.c += weight * d * d;
+}
+
+void addQuadric(Quadric& quadric, const Quadric& other)
+{
+    quadric.a00 += other.a00;
+    quadric.a01 += other.a01;
+    quadric.a02 += other.a02;
+    quadric.a11 += other.a11;
+    quadric.a12 += other.a12;
+    quadric.a22 += other.a22;
+    quadric.b0 += other.b0;
+    quadric.b1 += other.b1;
+    quadric.b2 += other.b2;
+    quadric.c += other.c;
+    quadric.weight += other.weight;
+}
+
+//Mean squared distance between the point and the planes of the quadric
+double evaluateQuadric(const Quadric& quadric, const glm::vec3& point)
+{
+    double x = point.x;
+    double y = point.y;
+    double z = point.z;
+
+    double result = quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z
+                    + 2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z)
+                    + 2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) + quadric.c;
+
+    return quadric.weight > 0.0 ? std::max(result, 0.0) / quadric.weight : std::max(result, 0.0);
+}
+
+uint64_t makeEdgeKey(uint32_t first, uint32_t second)
+{
+    return first < second ? (static_cast<uint64_t>(first) << 32) | second :
+           (static_cast<uint64_t>(second) << 32) | first;
+}
+
+//Vertices at the same position share an id, a position with several vertices is on a seam
+uint32_t computePositionIds(const std::vector<VertexAttribute>& vertices, std::vector<uint32_t>& positionIds,
+                            std::vector<uint8_t>& isSeam)
+{
+    std::vector<uint32_t> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&vertices](uint32_t left, uint32_t right)
+    {
+        const glm::vec3& l = vertices[left].pos;
+        const glm::vec3& r = vertices[right].pos;
+        return l.x < r.x || (l.x == r.x && (l.y < r.y || (l.y == r.y && l.z < r.z)));
+    });
+
+    positionIds.assign(vertices.size(), 0);
+    isSeam.assign(vertices.size(), 0);
+    uint32_t idCount = 0;
+
+    for(size_t idx = 0; idx < order.size(); idx++)
+    {
+        const glm::vec3& position = vertices[order[idx]].pos;
+
+        if(idx > 0 && vertices[order[idx - 1]].pos.x == position.x
+           && vertices[order[idx - 1]].pos.y == position.y && vertices[order[idx - 1]].pos.z == position.z)
+        {
+            positionIds[order[idx]] = idCount - 1;
+            isSeam[order[idx]] = 1;
+            isSeam[order[idx - 1]] = 1;
+        }
+        else
+        {
+            positionIds[order[idx]] = idCount++;
+        }
+    }
+
+    return idCount;
+}
+
+//Return true if moving vertex onto target turns over or folds one of the triangles kept around vertex
+bool isCollapseFlipping(uint32_t vertex, uint32_t target, const std::vector<VertexAttribute>& vertices,
+                        const std::vector<uint32_t>& indices, const std::vector<uint32_t>& adjacencyOffsets,
+                        const std::vector<uint32_t>& adjacency, const std::vector<uint32_t>& remap,
+                        const std::vector<uint32_t>& positionIds)
+{
+    const glm::vec3& targetPosition = vertices[target].pos;
+
+    for(uint32_t idx = adjacencyOffsets[vertex]; idx < adjacencyOffsets[vertex + 1]; idx++)
+    {
+        uint32_t triangle = adjacency[idx];
+        uint32_t corners[3];
+        bool isRemoved = false;
+
+        for(size_t idxCorner = 0; idxCorner < 3; idxCorner++)
+        {
+            //The collapses already done in this pass are taken into account
+            corners[idxCorner] = remap[indices[triangle * 3 + idxCorner]];
+            isRemoved |= positionIds[corners[idxCorner]] == positionIds[target];
+        }
+
+        if(isRemoved)
+        {
+            continue;
+        }
+
+        glm::vec3 positions[3] = { vertices[corners[0]].pos, vertices[corners[1]].pos, vertices[corners[2]].pos };
+        glm::vec3 normalBefore = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+
+        if(glm::dot(normalBefore, normalBefore) == 0.0f)
+        {
+            continue;
+        }
+
+        for(size_t idxCorner = 0; idxCorner < 3; idxCorner++)
+        {
+            if(corners[idxCorner] == vertex)
+            {
+                positions[idxCorner] = targetPosition;
+            }
+        }
+
+        glm::vec3 normalAfter = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+        float cosine = glm::dot(normalBefore, normalAfter);
+
+        if(cosine <= 0.0f || cosine * cosine < MIN_NORMAL_COSINE * MIN_NORMAL_COSINE
+           * glm::dot(normalBefore, normalBefore) * glm::dot(normalAfter, normalAfter))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<VertexAttribute>& vertices,
+                                   const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError,
+                                   float& resultError)
+{
+    std::vector<uint32_t> result(indices);
+    resultError = 0.0f;
+
+    if(indices.size() % 3 != 0 || vertices.empty())
+    {
+        return result;
+    }
+
+    size_t vertexCount = vertices.size();
+    std::vector<uint32_t> positionIds;
+    std::vector<uint8_t> isSeam;
+    uint32_t positionCount = computePositionIds(vertices, positionIds, isSeam);
+
+    //Plane of each triangle, weighted by its area, added to the quadrics of its vertices
+    std::vector<Quadric> quadrics(vertexCount);
+
+    for(size_t idxCorner = 0; idxCorner < result.size(); idxCorner += 3)
+    {
+        const glm::vec3& p0 = vertices[result[idxCorner]].pos;
+        glm::vec3 normal = glm::cross(vertices[result[idxCorner + 1]].pos - p0,
+                                      vertices[result[idxCorner + 2]].pos - p0);
+        float doubleArea = glm::length(normal);
+
+        if(doubleArea == 0.0f)
+        {
+            continue;
+        }
+
+        normal = normal / doubleArea;
+
+        for(size_t idx = 0; idx < 3; idx++)
+        {
+            Quadric& quadric = quadrics[result[idxCorner + idx]];
+            addPlane(quadric, normal, -glm::dot(normal, p0), 0.5 * doubleArea);
+            quadric.weight += 0.5 * doubleArea;
+        }
+    }
+
+    std::vector<uint64_t> edges;
+    std::vector<uint8_t> positionKinds(positionCount);
+    std::vector<uint8_t> kinds(vertexCount);
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> fillOffsets;
+    std::vector<double> bestCosts(vertexCount);
+    std::vector<uint32_t> bestTargets(vertexCount);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> isTouched(vertexCount);
+    double errorLimit = static_cast<double>(targetError) * targetError;
+    double maxError = 0.0;
+    bool isFirstPass = true;
+
+    while(result.size() > targetIndexCount)
+    {
+        //Edges between positions, used by a single triangle on a border and by more than 2 if non manifold
+        edges.clear();
+
+        for(size_t idxCorner = 0; idxCorner < result.size(); idxCorner += 3)
+        {
+            for(size_t idx = 0; idx < 3; idx++)
+            {
+                edges.push_back(makeEdgeKey(positionIds[result[idxCorner + idx]],
+                                            positionIds[result[idxCorner + (idx + 1) % 3]]));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+        std::fill(positionKinds.begin(), positionKinds.end(), static_cast<uint8_t>(MANIFOLD_VERTEX));
+
+        for(size_t idx = 0; idx < edges.size();)
+        {
+            size_t end = idx;
+
+            while(end < edges.size() && edges[end] == edges[idx])
+            {
+                end++;
+            }
+
+            uint8_t kind = end - idx == 1 ? BORDER_VERTEX : end - idx > 2 ? LOCKED_VERTEX : MANIFOLD_VERTEX;
+            uint8_t& firstKind = positionKinds[edges[idx] >> 32];
+            uint8_t& secondKind = positionKinds[edges[idx] & 0xFFFFFFFF];
+            firstKind = std::max(firstKind, kind);
+            secondKind = std::max(secondKind, kind);
+            idx = end;
+        }
+
+        auto isBorderEdge = [&edges, &positionIds](uint32_t first, uint32_t second)
+        {
+            auto range = std::equal_range(edges.begin(), edges.end(),
+                                          makeEdgeKey(positionIds[first], positionIds[second]));
+            return range.second - range.first == 1;
+        };
+
+        for(size_t idxVertex = 0; idxVertex < vertexCount; idxVertex++)
+        {
+            kinds[idxVertex] = isSeam[idxVertex] ? static_cast<uint8_t>(LOCKED_VERTEX) :
+                               positionKinds[positionIds[idxVertex]];
+        }
+
+        //The borders are kept in place by planes orthogonal to their triangles
+        if(isFirstPass)
+        {
+            for(size_t idxCorner = 0; idxCorner < result.size(); idxCorner += 3)
+            {
+                const glm::vec3& p0 = vertices[result[idxCorner]].pos;
+                glm::vec3 normal = glm::cross(vertices[result[idxCorner + 1]].pos - p0,
+                                              vertices[result[idxCorner + 2]].pos - p0);
+
+                for(size_t idx = 0; idx < 3; idx++)
+                {
+                    uint32_t first = result[idxCorner + idx];
+                    uint32_t second = result[idxCorner + (idx + 1) % 3];
+
+                    if(!isBorderEdge(first, second))
+                    {
+                        continue;
+                    }
+
+                    glm::vec3 edge = vertices[second].pos - vertices[first].pos;
+                    glm::vec3 borderNormal = glm::cross(edge, normal);
+                    float borderNormalLength = glm::length(borderNormal);
+
+                    if(borderNormalLength == 0.0f)
+                    {
+                        continue;
+                    }
+
+                    borderNormal = borderNormal / borderNormalLength;
+                    double weight = BORDER_WEIGHT * glm::dot(edge, edge);
+                    double d = -glm::dot(borderNormal, vertices[first].pos);
+                    addPlane(quadrics[first], borderNormal, d, weight);
+                    addPlane(quadrics[second], borderNormal, d, weight);
+                }
+            }
+
+            isFirstPass = false;
+        }
+
+        //Triangles around each vertex
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+
+        for(uint32_t index : result)
+        {
+            adjacencyOffsets[index + 1]++;
+        }
+
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(result.size());
+        fillOffsets.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+        for(size_t idxCorner = 0; idxCorner < result.size(); idxCorner++)
+        {
+            adjacency[fillOffsets[result[idxCorner]]++] = static_cast<uint32_t>(idxCorner / 3);
+        }
+
+        //Cheapest allowed collapse of each vertex
+        std::fill(bestCosts.begin(), bestCosts.end(), std::numeric_limits<double>::max());
+        std::fill(bestTargets.begin(), bestTargets.end(), NO_VERTEX);
+
+        for(size_t idxCorner = 0; idxCorner < result.size(); idxCorner += 3)
+        {
+            for(size_t idx = 0; idx < 6; idx++)
+            {
+                uint32_t vertex = result[idxCorner + idx % 3];
+                uint32_t target = result[idxCorner + (idx % 3 + (idx < 3 ? 1 : 2)) % 3];
+
+                if(kinds[vertex] == LOCKED_VERTEX || positionIds[vertex] == positionIds[target]
+                   || (kinds[vertex] == BORDER_VERTEX && !isBorderEdge(vertex, target)))
+                {
+                    continue;
+                }
+
+                double cost = evaluateQuadric(quadrics[vertex], vertices[target].pos);
+
+                if(cost < bestCosts[vertex])
+                {
+                    bestCosts[vertex] = cost;
+                    bestTargets[vertex] = target;
+                }
+            }
+        }
+
+        candidates.clear();
+
+        for(uint32_t idxVertex = 0; idxVertex < vertexCount; idxVertex++)
+        {
+            if(bestTargets[idxVertex] != NO_VERTEX && bestCosts[idxVertex] <= errorLimit)
+            {
+                candidates.push_back(idxVertex);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [&bestCosts](uint32_t left, uint32_t right)
+        {
+            return bestCosts[left] < bestCosts[right];
+        });
+
+        //Cheapest collapses first, a vertex takes part in a single collapse per pass
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(isTouched.begin(), isTouched.end(), 0);
+        size_t triangleGoal = (result.size() - targetIndexCount + 2) / 3;
+        size_t removedTriangles = 0;
+
+        for(uint32_t vertex : candidates)
+        {
+            if(removedTriangles >= triangleGoal)
+            {
+                break;
+            }
+
+            uint32_t target = bestTargets[vertex];
+
+            if(isTouched[vertex] || isTouched[target]
+               || isCollapseFlipping(vertex, target, vertices, result, adjacencyOffsets, adjacency, remap,
+                                     positionIds))
+            {
+                continue;
+            }
+
+            remap[vertex] = target;
+            isTouched[vertex] = 1;
+            isTouched[target] = 1;
+            addQuadric(quadrics[target], quadrics[vertex]);
+            removedTriangles += kinds[vertex] == BORDER_VERTEX ? 1 : 2;
+            maxError = std::max(maxError, bestCosts[vertex]);
+        }
+
+        if(removedTriangles == 0)
+        {
+            break;
+        }
+
+        //Remove the triangles that lost an edge, including those left between the two sides of a seam
+        size_t writeIndex = 0;
+
+        for(size_t idxCorner = 0; idxCorner < result.size(); idxCorner += 3)
+        {
+            uint32_t i0 = remap[result[idxCorner]];
+            uint32_t i1 = remap[result[idxCorner + 1]];
+            uint32_t i2 = remap[result[idxCorner + 2]];
+
+            if(positionIds[i0] == positionIds[i1] || positionIds[i1] == positionIds[i2]
+               || positionIds[i0] == positionIds[i2])
+            {
+                continue;
+            }
+
+            result[writeIndex++] = i0;
+            result[writeIndex++] = i1;
+            result[writeIndex++] = i2;
+        }
+
+        result.resize(writeIndex);
+    }
+
+    resultError = static_cast<float>(std::sqrt(maxError));
+    return result;
+}
+
+void generateLods(Mesh& mesh)
+{
+    mesh.lods.clear();
+    float error = 0.0f;
+
+    while(mesh.lods.size() < LOD_MAX_LEVEL_COUNT)
+    {
+        const std::vector<uint32_t>& source = mesh.lods.empty() ? mesh.indices : mesh.lods.back().indices;
+        size_t targetTriangleCount = static_cast<size_t>(source.size() / 3 * LOD_TRIANGLE_RATIO);
+
+        if(targetTriangleCount < LOD_MIN_TRIANGLE_COUNT)
+        {
+            break;
+        }
+
+        //Each level is simplified from the previous one, the errors add up
+        MeshLod lod;
+        float levelError;
+        lod.indices = simplifyMesh(mesh.vertices, source, targetTriangleCount * 3,
+                                   std::numeric_limits<float>::max(), levelError);
+
+        //Seams and borders are locked, they can prevent any further simplification
+        if(lod.indices.size() > source.size() * (1.0f - LOD_MIN_REDUCTION))
+        {
+            break;
+        }
+
+        error += levelError;
+        lod.error = error;
+        mesh.lods.push_back(std::move(lod));
+    }
+}
+
+}
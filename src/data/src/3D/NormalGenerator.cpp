@@ -0,0 +1,294 @@
+#include "data/3D/NormalGenerator.h"
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace data
+{
+
+namespace
+{
+
+const uint32_t NO_VERTEX = 0xFFFFFFFF;
+//Normal given to the vertices only used by degenerate triangles, the up axis of the Z up convention
+const glm::vec3 DEFAULT_NORMAL(0.0f, 0.0f, 1.0f);
+
+uint32_t hashPosition(const glm::vec3& position)
+{
+    uint32_t words[3];
+    memcpy(words, &position, sizeof(words));
+
+    uint32_t hash = 2166136261u;
+
+    for(uint32_t word : words)
+    {
+        hash = (hash ^ word) * 16777619u;
+    }
+
+    return hash ^ (hash >> 16);
+}
+
+//Same id for the vertices at the same position, return the number of ids
+uint32_t computePositionIds(const std::vector<VertexAttribute>& vertices, std::vector<uint32_t>& positionIds)
+{
+    size_t capacity = 16;
+
+    while(capacity < vertices.size() * 2)
+    {
+        capacity <<= 1;
+    }
+
+    //Open addressing table of the first vertex met at each position
+    std::vector<uint32_t> slots(capacity, NO_VERTEX);
+    size_t mask = capacity - 1;
+    uint32_t idCount = 0;
+    positionIds.resize(vertices.size());
+
+    for(size_t idxVertex = 0; idxVertex < vertices.size(); idxVertex++)
+    {
+        const glm::vec3& position = vertices[idxVertex].pos;
+        size_t slot = hashPosition(position) & mask;
+
+        while(slots[slot] != NO_VERTEX && vertices[slots[slot]].pos != position)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        if(slots[slot] == NO_VERTEX)
+        {
+            slots[slot] = static_cast<uint32_t>(idxVertex);
+            positionIds[idxVertex] = idCount++;
+        }
+        else
+        {
+            positionIds[idxVertex] = positionIds[slots[slot]];
+        }
+    }
+
+    return idCount;
+}
+
+void runBlocks(size_t count, const ParallelFor& parallelFor, const std::function<void(size_t, size_t)>& function)
+{
+    size_t blockCount = (count + NORMAL_BLOCK_SIZE - 1) / NORMAL_BLOCK_SIZE;
+    auto runBlock = [&](size_t idxBlock)
+    {
+        function(idxBlock * NORMAL_BLOCK_SIZE, std::min(count, (idxBlock + 1) * NORMAL_BLOCK_SIZE));
+    };
+
+    if(parallelFor && blockCount > 1)
+    {
+        parallelFor(blockCount, runBlock);
+    }
+    else
+    {
+        for(size_t idxBlock = 0; idxBlock < blockCount; idxBlock++)
+        {
+            runBlock(idxBlock);
+        }
+    }
+}
+
+glm::vec3 normalizeOrDefault(const glm::vec3& normal)
+{
+    float length = glm::length(normal);
+    return length > 0.0f ? normal / length : DEFAULT_NORMAL;
+}
+
+inline bool isNormalMissing(const VertexAttribute& vertex)
+{
+    return vertex.normal.x == 0.0f && vertex.normal.y == 0.0f && vertex.normal.z == 0.0f;
+}
+
+}
+
+bool hasNormals(const Mesh& mesh)
+{
+    for(const VertexAttribute& vertex : mesh.vertices)
+    {
+        if(isNormalMissing(vertex))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void generateNormals(Mesh& mesh, float creaseAngle, E_NormalWeighting weighting, const ParallelFor& parallelFor)
+{
+    size_t triangleCount = mesh.indices.size() / 3;
+
+    //Points : no face to average, a normal made up for them would only shade them wrongly
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> positionIds;
+    uint32_t positionCount = computePositionIds(mesh.vertices, positionIds);
+
+    //Unit normal of each face and weight of the face in the normal of each of its corners
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    std::vector<float> cornerWeights(mesh.indices.size());
+
+    runBlocks(triangleCount, parallelFor, [&](size_t first, size_t last)
+    {
+        for(size_t triangle = first; triangle < last; triangle++)
+        {
+            const glm::vec3* positions[3];
+
+            for(size_t idxCorner = 0; idxCorner < 3; idxCorner++)
+            {
+                positions[idxCorner] = &mesh.vertices[mesh.indices[triangle * 3 + idxCorner]].pos;
+            }
+
+            glm::vec3 normal = glm::cross(*positions[1] - *positions[0], *positions[2] - *positions[0]);
+            //Twice the area of the triangle, the degenerate triangles contribute to no normal
+            float length = glm::length(normal);
+            faceNormals[triangle] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+
+            for(size_t idxCorner = 0; idxCorner < 3; idxCorner++)
+            {
+                float weight = length;
+
+                if(weighting == ANGLE_WEIGHTING)
+                {
+                    glm::vec3 edge0 = *positions[(idxCorner + 1) % 3] - *positions[idxCorner];
+                    glm::vec3 edge1 = *positions[(idxCorner + 2) % 3] - *positions[idxCorner];
+                    float edgeLengths = glm::length(edge0) * glm::length(edge1);
+                    float cosine = edgeLengths > 0.0f ? glm::dot(edge0, edge1) / edgeLengths : 1.0f;
+                    weight = std::acos(std::max(-1.0f, std::min(1.0f, cosine)));
+                }
+
+                cornerWeights[triangle * 3 + idxCorner] = weight;
+            }
+        }
+    });
+
+    //Corners around each position, a block of positions then only reads the faces and writes its own normals
+    std::vector<uint32_t> offsets(positionCount + 1, 0);
+
+    for(uint32_t index : mesh.indices)
+    {
+        offsets[positionIds[index] + 1]++;
+    }
+
+    for(size_t idxPosition = 0; idxPosition < positionCount; idxPosition++)
+    {
+        offsets[idxPosition + 1] += offsets[idxPosition];
+    }
+
+    std::vector<uint32_t> corners(mesh.indices.size());
+    std::vector<uint32_t> fillOffsets(offsets.begin(), offsets.end() - 1);
+
+    for(size_t corner = 0; corner < mesh.indices.size(); corner++)
+    {
+        corners[fillOffsets[positionIds[mesh.indices[corner]]]++] = static_cast<uint32_t>(corner);
+    }
+
+    if(creaseAngle >= NO_CREASE_ANGLE)
+    {
+        std::vector<glm::vec3> positionNormals(positionCount);
+
+        runBlocks(positionCount, parallelFor, [&](size_t first, size_t last)
+        {
+            for(size_t idxPosition = first; idxPosition < last; idxPosition++)
+            {
+                glm::vec3 normal(0.0f);
+
+                for(uint32_t idx = offsets[idxPosition]; idx < offsets[idxPosition + 1]; idx++)
+                {
+                    normal += faceNormals[corners[idx] / 3] * cornerWeights[corners[idx]];
+                }
+
+                positionNormals[idxPosition] = normalizeOrDefault(normal);
+            }
+        });
+
+        runBlocks(mesh.vertices.size(), parallelFor, [&](size_t first, size_t last)
+        {
+            for(size_t idxVertex = first; idxVertex < last; idxVertex++)
+            {
+                if(isNormalMissing(mesh.vertices[idxVertex]))
+                {
+                    mesh.vertices[idxVertex].normal = positionNormals[positionIds[idxVertex]];
+                }
+            }
+        });
+
+        return;
+    }
+
+    //Each corner only averages the faces around its position close enough to its own face
+    float minCosine = std::cos(creaseAngle);
+    std::vector<glm::vec3> cornerNormals(mesh.indices.size());
+
+    runBlocks(positionCount, parallelFor, [&](size_t first, size_t last)
+    {
+        for(size_t idxPosition = first; idxPosition < last; idxPosition++)
+        {
+            for(uint32_t idx = offsets[idxPosition]; idx < offsets[idxPosition + 1]; idx++)
+            {
+                if(!isNormalMissing(mesh.vertices[mesh.indices[corners[idx]]]))
+                {
+                    continue;
+                }
+
+                const glm::vec3& faceNormal = faceNormals[corners[idx] / 3];
+                glm::vec3 normal(0.0f);
+
+                //Same faces in the same order for the corners on the same side of a crease, the sums are equal
+                for(uint32_t idxOther = offsets[idxPosition]; idxOther < offsets[idxPosition + 1]; idxOther++)
+                {
+                    uint32_t other = corners[idxOther];
+
+                    if(glm::dot(faceNormals[other / 3], faceNormal) >= minCosine)
+                    {
+                        normal += faceNormals[other / 3] * cornerWeights[other];
+                    }
+                }
+
+                cornerNormals[corners[idx]] = normalizeOrDefault(normal);
+            }
+        }
+    });
+
+    //A vertex used on both sides of a crease is duplicated, one copy per distinct normal. The vertices
+    //given a normal by the file keep it, they are never split
+    std::vector<VertexAttribute> vertices;
+    vertices.reserve(mesh.vertices.size());
+    std::vector<uint32_t> firstCopies(mesh.vertices.size(), NO_VERTEX);
+    std::vector<uint32_t> nextCopies;
+    nextCopies.reserve(mesh.vertices.size());
+
+    for(size_t corner = 0; corner < mesh.indices.size(); corner++)
+    {
+        uint32_t vertex = mesh.indices[corner];
+        uint32_t copy = firstCopies[vertex];
+        const glm::vec3& normal = isNormalMissing(mesh.vertices[vertex]) ? cornerNormals[corner] :
+                                  mesh.vertices[vertex].normal;
+
+        while(copy != NO_VERTEX && vertices[copy].normal != normal)
+        {
+            copy = nextCopies[copy];
+        }
+
+        if(copy == NO_VERTEX)
+        {
+            copy = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[vertex]);
+            vertices.back().normal = normal;
+            nextCopies.push_back(firstCopies[vertex]);
+            firstCopies[vertex] = copy;
+        }
+
+        mesh.indices[corner] = copy;
+    }
+
+    mesh.vertices.swap(vertices);
+}
+
+}
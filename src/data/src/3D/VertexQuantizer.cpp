@@ -0,0 +1,105 @@
+#include "data/3D/VertexQuantizer.h"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+#include <cmath>
+
+namespace data
+{
+
+namespace
+{
+
+const float UNORM16_MAX = 65535.0f;
+const float SNORM16_MAX = 32767.0f;
+
+inline float signNotZero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+}
+
+QuantizationBounds computeQuantizationBounds(const std::vector<VertexAttribute>& vertices)
+{
+    QuantizationBounds bounds;
+    glm::vec3 minPosition = vertices.empty() ? glm::vec3(0.0f) : vertices[0].pos;
+    glm::vec3 maxPosition = minPosition;
+
+    for(const VertexAttribute& vertex : vertices)
+    {
+        minPosition = glm::min(minPosition, vertex.pos);
+        maxPosition = glm::max(maxPosition, vertex.pos);
+    }
+
+    bounds.offset = minPosition;
+    bounds.scale = maxPosition - minPosition;
+    return bounds;
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3& normal)
+{
+    float norm1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+    if(norm1 == 0.0f)
+    {
+        return glm::vec2(0.0f);
+    }
+
+    glm::vec2 encoded(normal.x / norm1, normal.y / norm1);
+
+    //The lower half of the octahedron is folded on the corners of the square
+    if(normal.z < 0.0f)
+    {
+        encoded = glm::vec2((1.0f - std::abs(encoded.y)) * signNotZero(encoded.x),
+                            (1.0f - std::abs(encoded.x)) * signNotZero(encoded.y));
+    }
+
+    return encoded;
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& encoded)
+{
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+
+    if(normal.z < 0.0f)
+    {
+        normal.x = (1.0f - std::abs(encoded.y)) * signNotZero(encoded.x);
+        normal.y = (1.0f - std::abs(encoded.x)) * signNotZero(encoded.y);
+    }
+
+    return glm::normalize(normal);
+}
+
+void quantizeVertices(const std::vector<VertexAttribute>& vertices, const QuantizationBounds& bounds,
+                      std::vector<CompactVertexAttribute>& compactVertices)
+{
+    //A flat axis keeps a scale of 0 in the bounds, only the division is guarded
+    glm::vec3 inverseScale(bounds.scale.x > 0.0f ? 1.0f / bounds.scale.x : 0.0f,
+                           bounds.scale.y > 0.0f ? 1.0f / bounds.scale.y : 0.0f,
+                           bounds.scale.z > 0.0f ? 1.0f / bounds.scale.z : 0.0f);
+
+    compactVertices.resize(vertices.size());
+
+    for(size_t idx = 0; idx < vertices.size(); idx++)
+    {
+        const VertexAttribute& vertex = vertices[idx];
+        CompactVertexAttribute& compactVertex = compactVertices[idx];
+
+        glm::vec3 position = glm::clamp((vertex.pos - bounds.offset) * inverseScale, 0.0f, 1.0f);
+        glm::vec2 normal = encodeOctahedral(vertex.normal);
+
+        for(int idxAxis = 0; idxAxis < 3; idxAxis++)
+        {
+            compactVertex.pos[idxAxis] = static_cast<uint16_t>(position[idxAxis] * UNORM16_MAX + 0.5f);
+        }
+
+        compactVertex.pos[3] = 0;
+        compactVertex.normal[0] = static_cast<int16_t>(std::round(normal.x * SNORM16_MAX));
+        compactVertex.normal[1] = static_cast<int16_t>(std::round(normal.y * SNORM16_MAX));
+        compactVertex.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+        compactVertex.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+    }
+}
+
+}
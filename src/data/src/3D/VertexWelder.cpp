@@ -0,0 +1,113 @@
+#include "data/3D/VertexWelder.h"
+
+namespace data
+{
+
+namespace
+{
+
+size_t nextPowerOfTwo(size_t value)
+{
+    size_t power = 16;
+
+    while(power < value)
+    {
+        power <<= 1;
+    }
+
+    return power;
+}
+
+}
+
+bool VertexKey::operator==(const VertexKey& other) const
+{
+    return vertex == other.vertex && normal == other.normal && texCoord == other.texCoord;
+}
+
+VertexWelder::VertexWelder(size_t expectedVertices)
+{
+    reset(expectedVertices);
+}
+
+uint32_t VertexWelder::hash(const VertexKey& key)
+{
+    uint32_t hash = static_cast<uint32_t>(key.vertex) * 0x9E3779B1u;
+    hash ^= static_cast<uint32_t>(key.normal) * 0x85EBCA77u;
+    hash ^= static_cast<uint32_t>(key.texCoord) * 0xC2B2AE3Du;
+    return hash ^ (hash >> 15);
+}
+
+void VertexWelder::reset(size_t expectedVertices)
+{
+    //Keep the load factor under 0.5 so the probing sequences stay short
+    size_t capacity = nextPowerOfTwo(expectedVertices * 2);
+    Slot emptySlot = {};
+    emptySlot.value = EMPTY_SLOT;
+
+    slots_.assign(capacity, emptySlot);
+    mask_ = static_cast<uint32_t>(capacity - 1);
+    size_ = 0;
+}
+
+void VertexWelder::rehash(size_t capacity)
+{
+    std::vector<Slot> oldSlots;
+    oldSlots.swap(slots_);
+
+    Slot emptySlot = {};
+    emptySlot.value = EMPTY_SLOT;
+    slots_.assign(capacity, emptySlot);
+    mask_ = static_cast<uint32_t>(capacity - 1);
+
+    for(const Slot& slot : oldSlots)
+    {
+        if(slot.value == EMPTY_SLOT)
+        {
+            continue;
+        }
+
+        uint32_t idx = hash(slot.key) & mask_;
+
+        while(slots_[idx].value != EMPTY_SLOT)
+        {
+            idx = (idx + 1) & mask_;
+        }
+
+        slots_[idx] = slot;
+    }
+}
+
+uint32_t VertexWelder::findOrInsert(const VertexKey& key, uint32_t candidate, bool& inserted)
+{
+    if((size_ + 1) * 2 > slots_.size())
+    {
+        rehash(slots_.size() * 2);
+    }
+
+    uint32_t idx = hash(key) & mask_;
+
+    while(slots_[idx].value != EMPTY_SLOT)
+    {
+        if(slots_[idx].key == key)
+        {
+            inserted = false;
+            return slots_[idx].value;
+        }
+
+        idx = (idx + 1) & mask_;
+    }
+
+    slots_[idx].key = key;
+    slots_[idx].value = candidate;
+    size_++;
+    inserted = true;
+    return candidate;
+}
+
+uint32_t VertexWelder::size() const
+{
+    return size_;
+}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "loader/Loader.h"
+
+/*@brief : Loader of glTF 2.0 models, as a .gltf text with its buffers or as a single .glb. Every
+*          triangle primitive of the meshes placed by the nodes of the scene becomes a mesh, in the
+*          coordinates of the scene (Z up like the obj files). The binary buffers are mapped in memory
+*          and an interleaved vertex buffer with the layout of data::VertexAttribute or 32 bits indices
+*          are copied at once instead of being read element by element
+*/
+class GltfLoader : public Loader
+{
+public:
+    GltfLoader();
+    virtual ~GltfLoader() override;
+
+    bool loadStreaming(const std::string& path, const MeshCallback& onMesh) override;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum E_JsonType
+{
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+};
+
+/*@brief : Document of a JSON text (RFC 8259), enough for the headers of the binary formats. The
+*          accessors never fail : a missing member or an element of the wrong type reads as null
+*          and the conversions return the given default value
+*/
+class JsonValue
+{
+private:
+    E_JsonType type_ = JSON_NULL;
+    bool boolean_ = false;
+    double number_ = 0.0;
+    std::string string_;
+    std::vector<JsonValue> elements_;
+    //In the order of the text, the objects of the formats read have few members
+    std::vector<std::pair<std::string, JsonValue>> members_;
+
+    static const JsonValue NULL_VALUE;
+
+    class Parser;
+
+public:
+    JsonValue() = default;
+
+    // Return false and describe the first error if the text is not a single valid JSON value
+    static bool parse(const char* pText, size_t size, JsonValue& value, std::string& error);
+
+    E_JsonType getType() const;
+    bool isNull() const;
+    bool isArray() const;
+    bool isObject() const;
+
+    bool asBool(bool defaultValue = false) const;
+    double asNumber(double defaultValue = 0.0) const;
+    const std::string& asString() const;
+
+    // Number of elements of an array or of members of an object
+    size_t size() const;
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](const std::string& name) const;
+    bool hasMember(const std::string& name) const;
+};
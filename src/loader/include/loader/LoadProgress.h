@@ -0,0 +1,15 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*@brief : Progress of a load, written by the loading thread and read by the thread waiting for it.
+*          Setting cancelled asks the loader to stop as soon as possible, the load then fails
+*/
+struct LoadProgress
+{
+    std::atomic<uint64_t> totalBytes{0};
+    std::atomic<uint64_t> parsedBytes{0};
+    std::atomic<uint64_t> meshCount{0};
+    std::atomic<bool> cancelled{false};
+};
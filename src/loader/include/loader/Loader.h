@@ -10,19 +10,65 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <data/3D/Mesh.h>
+#include "loader/LoadProgress.h"
+
+class ThreadPool;
 
 class Loader
 {
-private:
+public:
+    // Receive a complete mesh, it is not modified anymore
+    using MeshCallback = std::function<void(const data::MeshPtr& mesh)>;
+
+protected:
+    struct OptimizationTotals
+    {
+        std::atomic<uint64_t> triangleCount{0};
+        std::atomic<uint64_t> vertexCount{0};
+        std::atomic<uint64_t> transformsBefore{0};
+        std::atomic<uint64_t> transformsAfter{0};
+        std::atomic<uint64_t> fetchedBytesBefore{0};
+        std::atomic<uint64_t> fetchedBytesAfter{0};
+    };
 
+    LoadProgress* pProgress_ = nullptr;
+    bool optimizationEnabled_ = true;
+    bool lodGenerationEnabled_ = true;
+    float normalCreaseAngle_;
+    OptimizationTotals optimizationTotals_;
+
+    bool isCancelled() const;
+
+    // Generate the normals missing from a loaded mesh and its levels of detail, then reorder it for
+    // the GPU caches. Can be called from several threads at once, also from the tasks of pPool. The
+    // normals of the large meshes are split on pPool, the pool of the load, nullptr keeps them on the
+    // calling thread
+    void processMesh(data::Mesh& mesh, ThreadPool* pPool);
+    void resetOptimizationTotals();
+    void logOptimizationTotals(const std::string& path) const;
 
 public:
     Loader();
     virtual ~Loader();
-    virtual bool load(const std::string& path, std::vector<data::Mesh>& scene) = 0;
+    // The meshes are only added to the scene if the whole file is loaded
+    virtual bool load(const std::string& path, std::vector<data::MeshPtr>& scene);
+    // Give each mesh to onMesh as soon as it is complete, in the order of the file. onMesh may be
+    // called from another thread than the caller's, one call at a time. If the load fails, the
+    // meshes already given are only part of the file
+    virtual bool loadStreaming(const std::string& path, const MeshCallback& onMesh) = 0;
+
+    // Progress reported by the next loads, nullptr to stop reporting it
+    virtual void setProgress(LoadProgress* pProgress);
+    void setOptimizationEnabled(bool enabled);
+    void setLodGenerationEnabled(bool enabled);
+    // Angle in radians above which the generated normals don't smooth two faces, data::NO_CREASE_ANGLE
+    // smooths every face
+    void setNormalCreaseAngle(float angle);
 };
 
 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "loader/Loader.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*@brief : Formats known by the application and the loader of each. The format of a file is found
+*          from its first bytes, then from its extension for the formats without a signature. A new
+*          loader is created for every file so that several files can be loaded at once
+*/
+class LoaderRegistry
+{
+public:
+    using LoaderFactory = std::function<std::unique_ptr<Loader>()>;
+    // Return true if the first bytes of a file are the signature of the format
+    using HeaderMatcher = std::function<bool(const char* pHeader, size_t size)>;
+
+    // Bytes read from the beginning of a file to recognize its format
+    static constexpr size_t HEADER_SIZE = 64;
+
+private:
+    struct Format
+    {
+        std::string name;
+        // Lower case, without the dot
+        std::vector<std::string> extensions;
+        HeaderMatcher matchHeader;
+        LoaderFactory createLoader;
+    };
+
+    std::vector<Format> formats_;
+
+    const Format* findFormat(const std::string& path) const;
+
+public:
+    LoaderRegistry();
+
+    // The formats are tried in the order they are registered, a null matcher only uses the extensions
+    void registerFormat(const std::string& name, const std::vector<std::string>& extensions,
+                        const HeaderMatcher& matchHeader, const LoaderFactory& createLoader);
+    // Registry of the obj, glTF and ply loaders
+    static LoaderRegistry createDefault();
+
+    // New loader for the file, nullptr if no format matches
+    std::unique_ptr<Loader> createLoader(const std::string& path) const;
+    // True if the extension of the path is one of a registered format, the file is not read
+    bool hasKnownExtension(const std::string& path) const;
+    std::vector<std::string> getExtensions() const;
+};
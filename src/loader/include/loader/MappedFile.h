@@ -0,0 +1,40 @@
+#pragma once
+
+#include <defines.h>
+#include <cstdint>
+#include <string>
+
+/*@brief : Read only view of a whole file mapped in memory, the loaders parse the content in place
+*          instead of copying it in an intermediate buffer
+*/
+class MappedFile
+{
+private:
+    const char* pData_ = nullptr;
+    size_t size_ = 0;
+
+#ifdef WIN32_
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+    ~MappedFile();
+
+    // The file is expected to be read sequentially, the system reads ahead more aggressively
+    bool open(const std::string& path);
+    void close();
+
+    // Tell the system the pages of the range won't be read anymore so they can be dropped
+    void release(size_t offset, size_t size) const;
+
+    bool isOpen() const;
+    const char* data() const;
+    size_t size() const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <data/3D/Mesh.h>
+#include "loader/Loader.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+/*@brief : Binary container (.avmesh) storing the meshes produced by a loader, so that the source
+*          file doesn't have to be parsed again when it is reopened
+*
+*  Layout : file header, one header per mesh, then the names, material, vertices, indices and levels
+*  of detail (a table of index ranges followed by their indices) of every mesh. The material is kept as
+*  it was when the cache was cooked, only the source file is checked. The arrays start on
+*  a DATA_ALIGNMENT boundary so they can be copied as is in a staging buffer. The source size and content
+*  hash identify the file the cache was cooked from, the loader settings how its meshes were processed.
+*/
+class MeshCache
+{
+private:
+    static const uint32_t VERSION;
+    static const uint64_t DATA_ALIGNMENT;
+
+public:
+    // Loader settings changing the cached meshes, a cache cooked with other settings is not read
+    struct Settings
+    {
+        bool optimizationEnabled;
+        bool lodGenerationEnabled;
+        float normalCreaseAngle;
+    };
+
+    // The content is hashed by blocks of this size, so that a file parsed by chunks can be hashed chunk
+    // by chunk : each block is hashed by the chunk it starts in
+    static const size_t HASH_BLOCK_SIZE;
+
+    static std::string getCachePath(const std::string& sourcePath);
+    static size_t getHashBlockCount(size_t size);
+    // Hash of the block idxBlock of a content, of at most HASH_BLOCK_SIZE bytes
+    static uint64_t hashBlock(const char* pData, size_t size, uint64_t idxBlock);
+    // Hash of a content of size bytes from the hashes of all its blocks, in order
+    static uint64_t combineBlockHashes(const std::vector<uint64_t>& blockHashes, size_t size);
+    static uint64_t hashContent(const char* pData, size_t size);
+
+    // Give the cached meshes to onMesh if the cache exists and was cooked from the content of source
+    static bool read(const std::string& cachePath, const MappedFile& source, const Settings& settings,
+                     const Loader::MeshCallback& onMesh);
+    // sourceHash is the hashContent of the source file
+    static bool write(const std::string& cachePath, size_t sourceSize, uint64_t sourceHash,
+                      const Settings& settings, const std::vector<data::MeshPtr>& scene);
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <data/3D/MaterialData.h>
+#include <string>
+#include <unordered_map>
+
+/*@brief : Reads the material libraries (.mtl) referenced by the obj files. Only the diffuse color and
+*          the diffuse texture are kept, the other statements are ignored
+*/
+class MtlParser
+{
+public:
+    using MaterialMap = std::unordered_map<std::string, data::MaterialData>;
+
+    // Add the materials of the library to materials, a material already in the map is replaced.
+    // The texture paths are relative to the directory of the library, they are joined to it
+    static bool parse(const std::string& path, MaterialMap& materials);
+    // Directory of the path with its trailing separator, empty if the path has no directory
+    static std::string getDirectory(const std::string& path);
+    // Path of a file named in a library of the directory, absolute names are kept
+    static std::string resolvePath(const std::string& directory, const std::string& path);
+};
@@ -1,14 +1,35 @@
 #pragma once
 
 #include "loader/Loader.h"
+#include "loader/ObjParser.h"
+
+enum E_ObjParser
+{
+    NATIVE_PARSER,
+    TINYOBJ_PARSER
+};
 
 class ObjLoader : public Loader
 {
 private:
-    /* data */
+    E_ObjParser parserType_ = NATIVE_PARSER;
+    ObjParser parser_;
+    bool cacheEnabled_ = true;
+
+    bool loadWithTinyObj(const std::string& path, const MeshCallback& onMesh);
+    bool loadWithNativeParser(const std::string& path, const MappedFile& file, const MeshCallback& onMesh,
+                              uint64_t* pContentHash);
+
 public:
     ObjLoader();
     virtual ~ObjLoader() override;
 
-    bool load(const std::string& path, std::vector<data::Mesh>& scene) override;
+    bool loadStreaming(const std::string& path, const MeshCallback& onMesh) override;
+    void setProgress(LoadProgress* pProgress) override;
+
+    void setParser(E_ObjParser parserType);
+    // Number of threads used by the native parser, 0 uses the number of hardware threads
+    void setThreadCount(size_t count);
+    // Read and write the .avmesh cache next to the loaded files
+    void setCacheEnabled(bool enabled);
 };
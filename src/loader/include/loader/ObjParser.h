@@ -0,0 +1,105 @@
+#pragma once
+
+#include <data/3D/Mesh.h>
+#include <data/3D/VertexWelder.h>
+#include "loader/Loader.h"
+#include "loader/MtlParser.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+struct LoadProgress;
+class MappedFile;
+class ThreadPool;
+
+/*@brief : Native obj parser. The text is split in line aligned chunks parsed in parallel, then the
+*          chunks are merged into welded meshes, one per object or group of the file and per material
+*          used in it
+*/
+class ObjParser
+{
+private:
+    static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+    // Amount of text parsed between two progress reports
+    static constexpr size_t PROGRESS_STEP = 1 << 18;
+
+    struct ShapeMarker
+    {
+        size_t firstTriangle;
+        std::string name;
+        //"usemtl" statement, name is the one of the material
+        bool isMaterial;
+    };
+
+    struct RelativeIndex
+    {
+        size_t corner;
+        int32_t data::VertexKey::* attribute;
+    };
+
+    struct Chunk
+    {
+        const char* begin;
+        const char* end;
+
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texCoords;
+        // 3 corners per triangle, polygons are triangulated as fans
+        std::vector<data::VertexKey> corners;
+        // Corner attributes given with negative indices, resolved once the chunk offsets are known
+        std::vector<RelativeIndex> relativeIndices;
+        std::vector<ShapeMarker> shapes;
+        // Files of the "mtllib" statements
+        std::vector<std::string> materialLibraries;
+    };
+
+    struct ShapeSegment
+    {
+        const Chunk* chunk;
+        size_t firstTriangle;
+        size_t lastTriangle;
+    };
+
+    struct Shape
+    {
+        std::string name;
+        std::string material;
+        std::vector<ShapeSegment> segments;
+    };
+
+    size_t threadCount_ = 0;
+    LoadProgress* pProgress_ = nullptr;
+    std::function<void(data::Mesh& mesh, ThreadPool* pPool)> meshProcessor_;
+    std::string materialDirectory_;
+
+    // Return false if the load was cancelled before the end of the chunk
+    static bool parseChunk(Chunk& chunk, LoadProgress* pProgress);
+    static void parseFace(const char* pLine, const char* pEnd, Chunk& chunk,
+                          std::vector<data::VertexKey>& polygon, std::vector<uint8_t>& relativeMasks);
+    static std::vector<Shape> gatherShapes(const std::vector<Chunk>& chunks);
+    static bool buildMesh(const Shape& shape, const std::vector<float>& positions,
+                          const std::vector<float>& normals, const std::vector<float>& texCoords, data::Mesh& mesh);
+    MtlParser::MaterialMap readMaterialLibraries(const std::vector<Chunk>& chunks) const;
+    bool parseText(const char* pData, size_t size, const MappedFile* pFile,
+                   const Loader::MeshCallback& onMesh, uint64_t* pContentHash);
+
+public:
+    ObjParser();
+
+    // A thread count of 0 uses the number of hardware threads
+    void setThreadCount(size_t count);
+    size_t getThreadCount() const;
+    void setProgress(LoadProgress* pProgress);
+    // Called on the worker threads on every mesh once it is built, before it is given to the caller.
+    // pPool is the pool of the parsing, the processor may split its work on it
+    void setMeshProcessor(const std::function<void(data::Mesh& mesh, ThreadPool* pPool)>& processor);
+    // Directory the material libraries are relative to, the one of the obj file
+    void setMaterialDirectory(const std::string& directory);
+
+    bool parse(const char* pData, size_t size, std::vector<data::MeshPtr>& scene);
+    // Parse the mapped text in place, the pages of each chunk are released once it is parsed.
+    // The meshes are given to onMesh in the order of the file, from the worker threads.
+    // pContentHash receives the MeshCache::hashContent of the file, computed before the pages are released
+    bool parse(const MappedFile& file, const Loader::MeshCallback& onMesh, uint64_t* pContentHash = nullptr);
+};
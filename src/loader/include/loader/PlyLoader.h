@@ -0,0 +1,18 @@
+#pragma once
+
+#include "loader/Loader.h"
+
+/*@brief : Loader of binary ply files (little or big endian), the format of most scans. The vertices
+*          are converted from the mapped file in blocks of fixed size, in parallel, and the pages of
+*          each block are released once read. A file with faces gives a single triangulated mesh, a
+*          file with vertices only gives point meshes of at most one block each, streamed as they are
+*          converted. The coordinates are kept as written, scans are usually Z up already
+*/
+class PlyLoader : public Loader
+{
+public:
+    PlyLoader();
+    virtual ~PlyLoader() override;
+
+    bool loadStreaming(const std::string& path, const MeshCallback& onMesh) override;
+};
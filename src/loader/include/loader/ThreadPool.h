@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*@brief : Fixed size pool of worker threads consuming a shared task queue
+*/
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_ = false;
+
+    void work();
+
+public:
+    // A thread count of 0 uses the number of hardware threads
+    explicit ThreadPool(size_t threadCount = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    size_t size() const;
+
+    template<typename Function>
+    auto enqueue(Function&& function) -> std::future<decltype(function())>;
+
+    // Call function(idx) for idx in [0, count) on the workers and the calling thread, and wait for all the
+    // calls to end. Can be called from a task of the same pool, e.g. to split a task in parallel
+    void parallelFor(size_t count, const std::function<void(size_t)>& function);
+};
+
+template<typename Function>
+auto ThreadPool::enqueue(Function&& function) -> std::future<decltype(function())>
+{
+    using Result = decltype(function());
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+    std::future<Result> result = task->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace([task]()
+        {
+            (*task)();
+        });
+    }
+
+    condition_.notify_one();
+    return result;
+}
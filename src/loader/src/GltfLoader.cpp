@@ -0,0 +1,921 @@
+#include "loader/GltfLoader.h"
+#include "loader/JsonValue.h"
+#include "loader/MappedFile.h"
+#include "loader/ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <plog/Log.h>
+
+namespace
+{
+
+const uint32_t GLB_MAGIC = 0x46546C67; //"glTF"
+const uint32_t GLB_VERSION = 2;
+const size_t GLB_HEADER_SIZE = 12;
+const size_t GLB_CHUNK_HEADER_SIZE = 8;
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+const int COMPONENT_BYTE = 5120;
+const int COMPONENT_UNSIGNED_BYTE = 5121;
+const int COMPONENT_SHORT = 5122;
+const int COMPONENT_UNSIGNED_SHORT = 5123;
+const int COMPONENT_UNSIGNED_INT = 5125;
+const int COMPONENT_FLOAT = 5126;
+
+const size_t MODE_TRIANGLES = 4;
+const size_t NO_INDEX = static_cast<size_t>(-1);
+//Deeper node hierarchies are taken for cycles
+const size_t MAX_NODE_DEPTH = 256;
+
+//glTF is Y up, the scene is Z up like the obj files : (x, y, z) -> (x, -z, y)
+const glm::mat4 AXIS_CONVERSION(glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+                                glm::vec4(0.0f, -1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+//Rounding of the rotations of the nodes, a Z up exporter rotating its root node cancels the axis conversion
+const float IDENTITY_EPSILON = 1e-6f;
+
+struct BufferRange
+{
+    const char* pData = nullptr;
+    size_t size = 0;
+};
+
+struct GltfDocument
+{
+    JsonValue json;
+    std::vector<BufferRange> buffers;
+    //Storage of the buffers not in the mapped file : external files and data uris
+    std::vector<MappedFile> bufferFiles;
+    std::vector<std::vector<char>> decodedBuffers;
+};
+
+//Elements of an accessor, validated against the bounds of their buffer view
+struct AccessorView
+{
+    const char* pData = nullptr;
+    size_t stride = 0;
+    size_t count = 0;
+    int componentType = 0;
+    size_t componentCount = 0;
+    bool normalized = false;
+};
+
+//Primitive placed in the scene by a node, a node instancing a mesh several times gives several items
+struct DrawItem
+{
+    size_t mesh;
+    size_t primitive;
+    glm::mat4 transform;
+    std::string name;
+};
+
+uint32_t readUint32(const char* pData)
+{
+    uint32_t value;
+    memcpy(&value, pData, sizeof(value));
+    return value;
+}
+
+//Non negative integer member, defaultValue if the member is missing
+bool readSize(const JsonValue& object, const char* name, size_t defaultValue, size_t& size)
+{
+    const JsonValue& value = object[name];
+
+    if(value.isNull())
+    {
+        size = defaultValue;
+        return true;
+    }
+
+    double number = value.asNumber(-1.0);
+
+    if(number < 0.0 || number != std::floor(number) || number >= 9007199254740992.0)
+    {
+        return false;
+    }
+
+    size = static_cast<size_t>(number);
+    return true;
+}
+
+size_t getComponentSize(int componentType)
+{
+    switch(componentType)
+    {
+    case COMPONENT_BYTE:
+    case COMPONENT_UNSIGNED_BYTE:
+        return 1;
+
+    case COMPONENT_SHORT:
+    case COMPONENT_UNSIGNED_SHORT:
+        return 2;
+
+    case COMPONENT_UNSIGNED_INT:
+    case COMPONENT_FLOAT:
+        return 4;
+
+    default:
+        return 0;
+    }
+}
+
+//Only the vector types are vertex attributes or indices, the matrices are left out
+size_t getComponentCount(const std::string& type)
+{
+    if(type == "SCALAR")
+    {
+        return 1;
+    }
+
+    if(type.size() == 4 && type.compare(0, 3, "VEC") == 0 && type[3] >= '2' && type[3] <= '4')
+    {
+        return type[3] - '0';
+    }
+
+    return 0;
+}
+
+int decodeBase64Digit(char c)
+{
+    if(c >= 'A' && c <= 'Z')
+    {
+        return c - 'A';
+    }
+
+    if(c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 26;
+    }
+
+    if(c >= '0' && c <= '9')
+    {
+        return c - '0' + 52;
+    }
+
+    if(c == '+' || c == '-')
+    {
+        return 62;
+    }
+
+    if(c == '/' || c == '_')
+    {
+        return 63;
+    }
+
+    return -1;
+}
+
+bool decodeBase64(const char* pText, size_t size, std::vector<char>& data)
+{
+    data.clear();
+    data.reserve(size / 4 * 3);
+    uint32_t bits = 0;
+    int bitCount = 0;
+
+    for(size_t idx = 0; idx < size && pText[idx] != '='; idx++)
+    {
+        int digit = decodeBase64Digit(pText[idx]);
+
+        if(digit < 0)
+        {
+            return false;
+        }
+
+        bits = (bits << 6) | static_cast<uint32_t>(digit);
+        bitCount += 6;
+
+        if(bitCount >= 8)
+        {
+            bitCount -= 8;
+            data.push_back(static_cast<char>((bits >> bitCount) & 0xFF));
+        }
+    }
+
+    return true;
+}
+
+//The uris of the external files are relative to the gltf file and may be percent encoded
+std::string decodeUri(const std::string& uri)
+{
+    std::string path;
+    path.reserve(uri.size());
+
+    for(size_t idx = 0; idx < uri.size(); idx++)
+    {
+        if(uri[idx] == '%' && idx + 2 < uri.size() && isxdigit(static_cast<unsigned char>(uri[idx + 1]))
+           && isxdigit(static_cast<unsigned char>(uri[idx + 2])))
+        {
+            path += static_cast<char>(std::stoi(uri.substr(idx + 1, 2), nullptr, 16));
+            idx += 2;
+        }
+        else
+        {
+            path += uri[idx];
+        }
+    }
+
+    return path;
+}
+
+bool loadBuffers(const std::string& path, const BufferRange& binChunk, GltfDocument& document)
+{
+    const JsonValue& buffers = document.json["buffers"];
+    document.buffers.resize(buffers.size());
+    document.bufferFiles.resize(buffers.size());
+    document.decodedBuffers.resize(buffers.size());
+    std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+
+    for(size_t idxBuffer = 0; idxBuffer < buffers.size(); idxBuffer++)
+    {
+        const JsonValue& buffer = buffers[idxBuffer];
+        const JsonValue& uri = buffer["uri"];
+        BufferRange& range = document.buffers[idxBuffer];
+        size_t byteLength;
+
+        if(!readSize(buffer, "byteLength", NO_INDEX, byteLength) || byteLength == NO_INDEX)
+        {
+            PLOGE << path << " : buffer " << idxBuffer << " has no valid byteLength" << '\n';
+            return false;
+        }
+
+        if(uri.isNull())
+        {
+            //Only the first buffer of a glb can refer to the binary chunk
+            if(idxBuffer == 0 && binChunk.pData)
+            {
+                range = binChunk;
+            }
+        }
+        else if(uri.asString().compare(0, 5, "data:") == 0)
+        {
+            const std::string& text = uri.asString();
+            size_t dataOffset = text.find(";base64,");
+
+            if(dataOffset != std::string::npos
+               && decodeBase64(text.data() + dataOffset + 8, text.size() - dataOffset - 8,
+                               document.decodedBuffers[idxBuffer]))
+            {
+                range.pData = document.decodedBuffers[idxBuffer].data();
+                range.size = document.decodedBuffers[idxBuffer].size();
+            }
+        }
+        else if(document.bufferFiles[idxBuffer].open(directory + decodeUri(uri.asString())))
+        {
+            range.pData = document.bufferFiles[idxBuffer].data();
+            range.size = document.bufferFiles[idxBuffer].size();
+        }
+
+        if(!range.pData || range.size < byteLength)
+        {
+            PLOGE << path << " : buffer " << idxBuffer << " is missing or shorter than its byteLength" << '\n';
+            return false;
+        }
+
+        range.size = byteLength;
+    }
+
+    return true;
+}
+
+bool readAccessor(const GltfDocument& document, size_t index, AccessorView& view)
+{
+    const JsonValue& accessor = document.json["accessors"][index];
+
+    if(!accessor.isObject())
+    {
+        PLOGE << "Accessor " << index << " does not exist" << '\n';
+        return false;
+    }
+
+    if(accessor.hasMember("sparse"))
+    {
+        PLOGE << "Accessor " << index << " is sparse, sparse accessors are not supported" << '\n';
+        return false;
+    }
+
+    size_t idxBufferView;
+    size_t accessorOffset;
+
+    if(!readSize(accessor, "bufferView", NO_INDEX, idxBufferView) || idxBufferView == NO_INDEX
+       || !readSize(accessor, "byteOffset", 0, accessorOffset) || !readSize(accessor, "count", 0, view.count))
+    {
+        PLOGE << "Accessor " << index << " has no buffer view or an invalid offset or count" << '\n';
+        return false;
+    }
+
+    view.componentType = static_cast<int>(accessor["componentType"].asNumber());
+    view.componentCount = getComponentCount(accessor["type"].asString());
+    view.normalized = accessor["normalized"].asBool();
+    size_t elementSize = getComponentSize(view.componentType) * view.componentCount;
+
+    if(elementSize == 0)
+    {
+        PLOGE << "Accessor " << index << " has an unsupported type" << '\n';
+        return false;
+    }
+
+    const JsonValue& bufferView = document.json["bufferViews"][idxBufferView];
+    size_t idxBuffer;
+    size_t viewOffset;
+    size_t viewLength;
+    size_t viewStride;
+
+    if(!bufferView.isObject() || !readSize(bufferView, "buffer", NO_INDEX, idxBuffer)
+       || idxBuffer >= document.buffers.size() || !readSize(bufferView, "byteOffset", 0, viewOffset)
+       || !readSize(bufferView, "byteLength", NO_INDEX, viewLength) || !readSize(bufferView, "byteStride", 0, viewStride)
+       || viewOffset > document.buffers[idxBuffer].size
+       || viewLength > document.buffers[idxBuffer].size - viewOffset)
+    {
+        PLOGE << "Buffer view " << idxBufferView << " of accessor " << index << " is invalid" << '\n';
+        return false;
+    }
+
+    view.stride = viewStride > 0 ? viewStride : elementSize;
+
+    //The last element must end in the view
+    if(view.count > 0 && (accessorOffset > viewLength || elementSize > viewLength - accessorOffset
+                          || (view.count - 1) > (viewLength - accessorOffset - elementSize) / view.stride))
+    {
+        PLOGE << "Accessor " << index << " overflows its buffer view" << '\n';
+        return false;
+    }
+
+    view.pData = document.buffers[idxBuffer].pData + viewOffset + accessorOffset;
+    return true;
+}
+
+//Components of an element as floats, the normalized integers are mapped to [0, 1] or [-1, 1]
+void readFloats(const AccessorView& view, size_t idxElement, float* pValues)
+{
+    const char* pElement = view.pData + idxElement * view.stride;
+
+    for(size_t idx = 0; idx < view.componentCount; idx++)
+    {
+        switch(view.componentType)
+        {
+        case COMPONENT_FLOAT:
+            memcpy(&pValues[idx], pElement + idx * 4, 4);
+            break;
+
+        case COMPONENT_UNSIGNED_BYTE:
+        {
+            float value = static_cast<uint8_t>(pElement[idx]);
+            pValues[idx] = view.normalized ? value / 255.0f : value;
+            break;
+        }
+
+        case COMPONENT_BYTE:
+        {
+            float value = static_cast<int8_t>(pElement[idx]);
+            pValues[idx] = view.normalized ? std::max(value / 127.0f, -1.0f) : value;
+            break;
+        }
+
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            uint16_t value;
+            memcpy(&value, pElement + idx * 2, 2);
+            pValues[idx] = view.normalized ? value / 65535.0f : value;
+            break;
+        }
+
+        case COMPONENT_SHORT:
+        {
+            int16_t value;
+            memcpy(&value, pElement + idx * 2, 2);
+            pValues[idx] = view.normalized ? std::max(value / 32767.0f, -1.0f) : value;
+            break;
+        }
+
+        default:
+        {
+            uint32_t value;
+            memcpy(&value, pElement + idx * 4, 4);
+            pValues[idx] = static_cast<float>(value);
+            break;
+        }
+        }
+    }
+}
+
+//True if the three accessors interleave their elements exactly like data::VertexAttribute
+bool hasVertexAttributeLayout(const AccessorView& positions, const AccessorView& normals,
+                              const AccessorView& texCoords)
+{
+    return positions.stride == sizeof(data::VertexAttribute) && normals.stride == positions.stride
+           && texCoords.stride == positions.stride && normals.count == positions.count
+           && texCoords.count == positions.count && normals.componentType == COMPONENT_FLOAT
+           && texCoords.componentType == COMPONENT_FLOAT
+           && normals.pData == positions.pData + offsetof(data::VertexAttribute, normal)
+           && texCoords.pData == positions.pData + offsetof(data::VertexAttribute, texCoord);
+}
+
+bool isIdentity(const glm::mat4& transform)
+{
+    for(int column = 0; column < 4; column++)
+    {
+        for(int row = 0; row < 4; row++)
+        {
+            if(std::abs(transform[column][row] - (column == row ? 1.0f : 0.0f)) > IDENTITY_EPSILON)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+glm::mat4 getNodeTransform(const JsonValue& node)
+{
+    const JsonValue& matrix = node["matrix"];
+
+    if(matrix.size() == 16)
+    {
+        //Column major, like glm
+        float values[16];
+
+        for(size_t idx = 0; idx < 16; idx++)
+        {
+            values[idx] = static_cast<float>(matrix[idx].asNumber());
+        }
+
+        return glm::make_mat4(values);
+    }
+
+    const JsonValue& translation = node["translation"];
+    const JsonValue& rotation = node["rotation"];
+    const JsonValue& scale = node["scale"];
+    glm::mat4 transform(1.0f);
+
+    if(translation.size() == 3)
+    {
+        transform = glm::translate(transform, glm::vec3(translation[0].asNumber(), translation[1].asNumber(),
+                                   translation[2].asNumber()));
+    }
+
+    if(rotation.size() == 4)
+    {
+        //Stored x, y, z, w
+        glm::quat quaternion(static_cast<float>(rotation[3].asNumber(1.0)), static_cast<float>(rotation[0].asNumber()),
+                             static_cast<float>(rotation[1].asNumber()), static_cast<float>(rotation[2].asNumber()));
+        transform = transform * glm::mat4_cast(glm::normalize(quaternion));
+    }
+
+    if(scale.size() == 3)
+    {
+        transform = glm::scale(transform, glm::vec3(scale[0].asNumber(1.0), scale[1].asNumber(1.0),
+                               scale[2].asNumber(1.0)));
+    }
+
+    return transform;
+}
+
+void addMeshItems(const JsonValue& json, size_t idxMesh, const glm::mat4& transform, const std::string& name,
+                  std::vector<DrawItem>& items)
+{
+    const JsonValue& primitives = json["meshes"][idxMesh]["primitives"];
+
+    for(size_t idxPrimitive = 0; idxPrimitive < primitives.size(); idxPrimitive++)
+    {
+        size_t mode;
+
+        if(!readSize(primitives[idxPrimitive], "mode", MODE_TRIANGLES, mode) || mode != MODE_TRIANGLES)
+        {
+            PLOGW << "Primitive " << idxPrimitive << " of " << name << " skipped : only triangle lists are supported"
+                  << '\n';
+            continue;
+        }
+
+        std::string primitiveName = primitives.size() > 1 ? name + "_" + std::to_string(idxPrimitive) : name;
+        items.push_back({ idxMesh, idxPrimitive, transform, primitiveName });
+    }
+}
+
+bool gatherNode(const JsonValue& json, size_t idxNode, const glm::mat4& parentTransform, size_t depth,
+                std::vector<DrawItem>& items)
+{
+    const JsonValue& node = json["nodes"][idxNode];
+
+    if(!node.isObject() || depth > MAX_NODE_DEPTH)
+    {
+        PLOGE << "Node " << idxNode << " does not exist or is part of a cycle" << '\n';
+        return false;
+    }
+
+    glm::mat4 transform = parentTransform * getNodeTransform(node);
+    size_t idxMesh;
+
+    if(!readSize(node, "mesh", NO_INDEX, idxMesh))
+    {
+        return false;
+    }
+
+    if(idxMesh != NO_INDEX)
+    {
+        if(!json["meshes"][idxMesh].isObject())
+        {
+            PLOGE << "Mesh " << idxMesh << " of node " << idxNode << " does not exist" << '\n';
+            return false;
+        }
+
+        std::string name = node["name"].asString();
+
+        if(name.empty())
+        {
+            name = json["meshes"][idxMesh]["name"].asString();
+        }
+
+        if(name.empty())
+        {
+            name = "mesh_" + std::to_string(idxMesh);
+        }
+
+        addMeshItems(json, idxMesh, transform, name, items);
+    }
+
+    const JsonValue& children = node["children"];
+
+    for(size_t idx = 0; idx < children.size(); idx++)
+    {
+        double child = children[idx].asNumber(-1.0);
+
+        if(child < 0.0 || !gatherNode(json, static_cast<size_t>(child), transform, depth + 1, items))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Primitives of the default scene, of every mesh if the file has no scene
+bool gatherDrawItems(const JsonValue& json, std::vector<DrawItem>& items)
+{
+    const JsonValue& scenes = json["scenes"];
+
+    if(scenes.size() == 0)
+    {
+        for(size_t idxMesh = 0; idxMesh < json["meshes"].size(); idxMesh++)
+        {
+            std::string name = json["meshes"][idxMesh]["name"].asString();
+            addMeshItems(json, idxMesh, AXIS_CONVERSION, name.empty() ? "mesh_" + std::to_string(idxMesh) : name,
+                         items);
+        }
+
+        return true;
+    }
+
+    size_t idxScene;
+
+    if(!readSize(json, "scene", 0, idxScene) || !scenes[idxScene].isObject())
+    {
+        PLOGE << "The default scene does not exist" << '\n';
+        return false;
+    }
+
+    const JsonValue& nodes = scenes[idxScene]["nodes"];
+
+    for(size_t idx = 0; idx < nodes.size(); idx++)
+    {
+        double node = nodes[idx].asNumber(-1.0);
+
+        if(node < 0.0 || !gatherNode(json, static_cast<size_t>(node), AXIS_CONVERSION, 0, items))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool readIndices(const GltfDocument& document, const JsonValue& primitive, size_t vertexCount,
+                 std::vector<uint32_t>& indices)
+{
+    size_t idxAccessor;
+
+    if(!readSize(primitive, "indices", NO_INDEX, idxAccessor))
+    {
+        return false;
+    }
+
+    //Not indexed : every 3 vertices are a triangle
+    if(idxAccessor == NO_INDEX)
+    {
+        indices.resize(vertexCount - vertexCount % 3);
+
+        for(size_t idx = 0; idx < indices.size(); idx++)
+        {
+            indices[idx] = static_cast<uint32_t>(idx);
+        }
+
+        return true;
+    }
+
+    AccessorView view;
+
+    if(!readAccessor(document, idxAccessor, view) || view.componentCount != 1)
+    {
+        return false;
+    }
+
+    indices.resize(view.count - view.count % 3);
+
+    if(view.componentType == COMPONENT_UNSIGNED_INT && view.stride == 4)
+    {
+        memcpy(indices.data(), view.pData, indices.size() * 4);
+    }
+    else if(view.componentType == COMPONENT_UNSIGNED_SHORT)
+    {
+        for(size_t idx = 0; idx < indices.size(); idx++)
+        {
+            uint16_t index;
+            memcpy(&index, view.pData + idx * view.stride, 2);
+            indices[idx] = index;
+        }
+    }
+    else if(view.componentType == COMPONENT_UNSIGNED_BYTE)
+    {
+        for(size_t idx = 0; idx < indices.size(); idx++)
+        {
+            indices[idx] = static_cast<uint8_t>(view.pData[idx * view.stride]);
+        }
+    }
+    else if(view.componentType == COMPONENT_UNSIGNED_INT)
+    {
+        for(size_t idx = 0; idx < indices.size(); idx++)
+        {
+            indices[idx] = readUint32(view.pData + idx * view.stride);
+        }
+    }
+    else
+    {
+        PLOGE << "Accessor " << idxAccessor << " has an invalid index type" << '\n';
+        return false;
+    }
+
+    for(uint32_t index : indices)
+    {
+        if(index >= vertexCount)
+        {
+            PLOGE << "Accessor " << idxAccessor << " has an index out of the vertices" << '\n';
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool buildMesh(const GltfDocument& document, const DrawItem& item, data::Mesh& mesh)
+{
+    const JsonValue& primitive = document.json["meshes"][item.mesh]["primitives"][item.primitive];
+    const JsonValue& attributes = primitive["attributes"];
+    size_t idxPositions;
+    size_t idxNormals;
+    size_t idxTexCoords;
+    AccessorView positions;
+    AccessorView normals;
+    AccessorView texCoords;
+
+    if(!readSize(attributes, "POSITION", NO_INDEX, idxPositions) || idxPositions == NO_INDEX
+       || !readSize(attributes, "NORMAL", NO_INDEX, idxNormals)
+       || !readSize(attributes, "TEXCOORD_0", NO_INDEX, idxTexCoords)
+       || !readAccessor(document, idxPositions, positions)
+       || (idxNormals != NO_INDEX && !readAccessor(document, idxNormals, normals))
+       || (idxTexCoords != NO_INDEX && !readAccessor(document, idxTexCoords, texCoords)))
+    {
+        PLOGE << item.name << " : invalid or missing vertex attributes" << '\n';
+        return false;
+    }
+
+    if(positions.componentType != COMPONENT_FLOAT || positions.componentCount != 3
+       || (normals.pData && (normals.componentCount != 3 || normals.count != positions.count))
+       || (texCoords.pData && (texCoords.componentCount != 2 || texCoords.count != positions.count)))
+    {
+        PLOGE << item.name << " : vertex attributes of unexpected types or counts" << '\n';
+        return false;
+    }
+
+    mesh.name = item.name;
+    mesh.vertices.resize(positions.count);
+
+    if(normals.pData && texCoords.pData && hasVertexAttributeLayout(positions, normals, texCoords))
+    {
+        //The buffer view already holds the vertices as the renderer reads them
+        memcpy(mesh.vertices.data(), positions.pData, positions.count * sizeof(data::VertexAttribute));
+    }
+    else
+    {
+        for(size_t idxVertex = 0; idxVertex < positions.count; idxVertex++)
+        {
+            data::VertexAttribute& vertex = mesh.vertices[idxVertex];
+            readFloats(positions, idxVertex, &vertex.pos.x);
+
+            if(normals.pData)
+            {
+                readFloats(normals, idxVertex, &vertex.normal.x);
+            }
+
+            if(texCoords.pData)
+            {
+                readFloats(texCoords, idxVertex, &vertex.texCoord.x);
+            }
+        }
+    }
+
+    if(!readIndices(document, primitive, positions.count, mesh.indices))
+    {
+        return false;
+    }
+
+    //Already in the coordinates of the scene, the vertices copied at once are left as they are
+    if(isIdentity(item.transform))
+    {
+        return true;
+    }
+
+    //Into the coordinates of the scene, the normals by the inverse transpose
+    glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(item.transform)));
+
+    for(data::VertexAttribute& vertex : mesh.vertices)
+    {
+        glm::vec4 position = item.transform * glm::vec4(vertex.pos, 1.0f);
+        vertex.pos = glm::vec3(position.x, position.y, position.z);
+
+        if(vertex.normal != glm::vec3(0.0f))
+        {
+            vertex.normal = glm::normalize(normalTransform * vertex.normal);
+        }
+    }
+
+    //A mirroring transform turns the triangles inside out
+    if(glm::determinant(glm::mat3(item.transform)) < 0.0f)
+    {
+        for(size_t idx = 0; idx < mesh.indices.size(); idx += 3)
+        {
+            std::swap(mesh.indices[idx + 1], mesh.indices[idx + 2]);
+        }
+    }
+
+    return true;
+}
+
+}
+
+GltfLoader::GltfLoader() :
+    Loader()
+{
+
+}
+
+GltfLoader::~GltfLoader()
+{
+
+}
+
+bool GltfLoader::loadStreaming(const std::string& path, const MeshCallback& onMesh)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    MappedFile file;
+
+    if(!file.open(path))
+    {
+        return false;
+    }
+
+    if(pProgress_)
+    {
+        pProgress_->totalBytes = file.size();
+    }
+
+    GltfDocument document;
+    const char* pJson = file.data();
+    size_t jsonSize = file.size();
+    BufferRange binChunk;
+
+    if(file.size() >= GLB_HEADER_SIZE && readUint32(file.data()) == GLB_MAGIC)
+    {
+        size_t length = readUint32(file.data() + 8);
+
+        if(readUint32(file.data() + 4) != GLB_VERSION || length > file.size()
+           || length < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE
+           || readUint32(file.data() + GLB_HEADER_SIZE + 4) != GLB_CHUNK_JSON)
+        {
+            PLOGE << path << " is not a valid glb 2.0 file" << '\n';
+            return false;
+        }
+
+        pJson = file.data() + GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE;
+        jsonSize = readUint32(file.data() + GLB_HEADER_SIZE);
+        size_t binOffset = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE + jsonSize;
+
+        if(jsonSize > length - GLB_HEADER_SIZE - GLB_CHUNK_HEADER_SIZE)
+        {
+            PLOGE << path << " : the json chunk overflows the file" << '\n';
+            return false;
+        }
+
+        //The binary chunk is optional, the buffers can all be external
+        if(length - binOffset >= GLB_CHUNK_HEADER_SIZE && readUint32(file.data() + binOffset + 4) == GLB_CHUNK_BIN)
+        {
+            binChunk.pData = file.data() + binOffset + GLB_CHUNK_HEADER_SIZE;
+            binChunk.size = std::min<size_t>(readUint32(file.data() + binOffset),
+                                             length - binOffset - GLB_CHUNK_HEADER_SIZE);
+        }
+    }
+
+    std::string error;
+
+    if(!JsonValue::parse(pJson, jsonSize, document.json, error))
+    {
+        PLOGE << path << " : invalid json, " << error << '\n';
+        return false;
+    }
+
+    const JsonValue& requiredExtensions = document.json["extensionsRequired"];
+
+    for(size_t idx = 0; idx < requiredExtensions.size(); idx++)
+    {
+        PLOGE << path << " requires the unsupported extension " << requiredExtensions[idx].asString() << '\n';
+    }
+
+    std::vector<DrawItem> items;
+
+    if(requiredExtensions.size() > 0 || !loadBuffers(path, binChunk, document)
+       || !gatherDrawItems(document.json, items))
+    {
+        return false;
+    }
+
+    auto parseTime = std::chrono::high_resolution_clock::now();
+    resetOptimizationTotals();
+
+    ThreadPool pool;
+    std::vector<data::Mesh> meshes(items.size());
+    std::atomic<bool> isValid(true);
+
+    //The meshes are given in the order of the scene as soon as all the previous ones are built
+    std::mutex emitMutex;
+    std::vector<uint8_t> isBuilt(items.size(), 0);
+    size_t nextMesh = 0;
+
+    pool.parallelFor(items.size(), [&](size_t idx)
+    {
+        if(!isValid || isCancelled())
+        {
+            isValid = false;
+            return;
+        }
+
+        if(!buildMesh(document, items[idx], meshes[idx]))
+        {
+            isValid = false;
+            return;
+        }
+
+        processMesh(meshes[idx], &pool);
+
+        std::lock_guard<std::mutex> lock(emitMutex);
+        isBuilt[idx] = 1;
+
+        while(isValid && nextMesh < meshes.size() && isBuilt[nextMesh])
+        {
+            if(pProgress_)
+            {
+                pProgress_->meshCount++;
+                pProgress_->parsedBytes = file.size() * (nextMesh + 1) / meshes.size();
+            }
+
+            onMesh(std::make_shared<const data::Mesh>(std::move(meshes[nextMesh])));
+            meshes[nextMesh++] = data::Mesh();
+        }
+    });
+
+    if(!isValid)
+    {
+        return false;
+    }
+
+    if(pProgress_)
+    {
+        pProgress_->parsedBytes = file.size();
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    PLOGI << path << " loaded in "
+          << std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count()
+          << " ms : json " << std::chrono::duration<float, std::chrono::milliseconds::period>
+          (parseTime - startTime).count() << " ms, " << items.size() << " primitives built with " << pool.size()
+          << " threads" << '\n';
+
+    logOptimizationTotals(path);
+    return true;
+}
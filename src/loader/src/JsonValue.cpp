@@ -0,0 +1,492 @@
+#include "loader/JsonValue.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+const JsonValue JsonValue::NULL_VALUE;
+
+namespace
+{
+
+//Nesting allowed before the text is rejected, the parser is recursive
+const int MAX_DEPTH = 256;
+
+}
+
+class JsonValue::Parser
+{
+private:
+    const char* p_;
+    const char* pEnd_;
+    const char* pBegin_;
+    std::string error_;
+
+    void skipSpaces()
+    {
+        while(p_ < pEnd_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r'))
+        {
+            p_++;
+        }
+    }
+
+    bool fail(const char* message)
+    {
+        if(error_.empty())
+        {
+            error_ = std::string(message) + " at offset " + std::to_string(p_ - pBegin_);
+        }
+
+        return false;
+    }
+
+    bool expect(const char* word)
+    {
+        size_t length = strlen(word);
+
+        if(static_cast<size_t>(pEnd_ - p_) < length || memcmp(p_, word, length) != 0)
+        {
+            return fail("Invalid literal");
+        }
+
+        p_ += length;
+        return true;
+    }
+
+    static void appendUtf8(uint32_t codePoint, std::string& string)
+    {
+        if(codePoint < 0x80)
+        {
+            string += static_cast<char>(codePoint);
+        }
+        else if(codePoint < 0x800)
+        {
+            string += static_cast<char>(0xC0 | (codePoint >> 6));
+            string += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if(codePoint < 0x10000)
+        {
+            string += static_cast<char>(0xE0 | (codePoint >> 12));
+            string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            string += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            string += static_cast<char>(0xF0 | (codePoint >> 18));
+            string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            string += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(uint32_t& value)
+    {
+        if(pEnd_ - p_ < 4)
+        {
+            return fail("Truncated unicode escape");
+        }
+
+        value = 0;
+
+        for(int idx = 0; idx < 4; idx++)
+        {
+            char c = *p_++;
+            value <<= 4;
+
+            if(c >= '0' && c <= '9')
+            {
+                value |= c - '0';
+            }
+            else if(c >= 'a' && c <= 'f')
+            {
+                value |= c - 'a' + 10;
+            }
+            else if(c >= 'A' && c <= 'F')
+            {
+                value |= c - 'A' + 10;
+            }
+            else
+            {
+                return fail("Invalid unicode escape");
+            }
+        }
+
+        return true;
+    }
+
+    bool parseString(std::string& string)
+    {
+        //Opening quote already checked by the caller
+        p_++;
+
+        while(p_ < pEnd_ && *p_ != '"')
+        {
+            //Copy the unescaped runs at once
+            const char* pRun = p_;
+
+            while(p_ < pEnd_ && *p_ != '"' && *p_ != '\\')
+            {
+                if(static_cast<unsigned char>(*p_) < 0x20)
+                {
+                    return fail("Control character in string");
+                }
+
+                p_++;
+            }
+
+            string.append(pRun, p_ - pRun);
+
+            if(p_ >= pEnd_ || *p_ == '"')
+            {
+                break;
+            }
+
+            p_++;
+
+            if(p_ >= pEnd_)
+            {
+                break;
+            }
+
+            char escaped = *p_++;
+
+            switch(escaped)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                string += escaped;
+                break;
+
+            case 'b':
+                string += '\b';
+                break;
+
+            case 'f':
+                string += '\f';
+                break;
+
+            case 'n':
+                string += '\n';
+                break;
+
+            case 'r':
+                string += '\r';
+                break;
+
+            case 't':
+                string += '\t';
+                break;
+
+            case 'u':
+            {
+                uint32_t codePoint;
+
+                if(!parseHex4(codePoint))
+                {
+                    return false;
+                }
+
+                //Surrogate pair, the low half follows as a second escape
+                if(codePoint >= 0xD800 && codePoint < 0xDC00)
+                {
+                    uint32_t low;
+
+                    if(pEnd_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u')
+                    {
+                        return fail("Missing low surrogate");
+                    }
+
+                    p_ += 2;
+
+                    if(!parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                    {
+                        return fail("Invalid low surrogate");
+                    }
+
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+
+                appendUtf8(codePoint, string);
+                break;
+            }
+
+            default:
+                return fail("Invalid escape");
+            }
+        }
+
+        if(p_ >= pEnd_)
+        {
+            return fail("Unterminated string");
+        }
+
+        p_++;
+        return true;
+    }
+
+    bool parseNumber(double& number)
+    {
+        const char* pStart = p_;
+
+        if(p_ < pEnd_ && *p_ == '-')
+        {
+            p_++;
+        }
+
+        if(p_ >= pEnd_ || *p_ < '0' || *p_ > '9')
+        {
+            return fail("Invalid number");
+        }
+
+        while(p_ < pEnd_ && ((*p_ >= '0' && *p_ <= '9') || *p_ == '.' || *p_ == 'e' || *p_ == 'E'
+                             || *p_ == '+' || *p_ == '-'))
+        {
+            p_++;
+        }
+
+        //strtod needs a terminated string, the numbers are short
+        std::string text(pStart, p_ - pStart);
+        char* pParsedEnd;
+        number = strtod(text.c_str(), &pParsedEnd);
+
+        if(pParsedEnd != text.c_str() + text.size())
+        {
+            return fail("Invalid number");
+        }
+
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth)
+    {
+        if(depth > MAX_DEPTH)
+        {
+            return fail("Too deeply nested");
+        }
+
+        skipSpaces();
+
+        if(p_ >= pEnd_)
+        {
+            return fail("Unexpected end of text");
+        }
+
+        switch(*p_)
+        {
+        case '{':
+            value.type_ = JSON_OBJECT;
+            p_++;
+            skipSpaces();
+
+            if(p_ < pEnd_ && *p_ == '}')
+            {
+                p_++;
+                return true;
+            }
+
+            while(true)
+            {
+                skipSpaces();
+
+                if(p_ >= pEnd_ || *p_ != '"')
+                {
+                    return fail("Expected a member name");
+                }
+
+                value.members_.emplace_back();
+
+                if(!parseString(value.members_.back().first))
+                {
+                    return false;
+                }
+
+                skipSpaces();
+
+                if(p_ >= pEnd_ || *p_ != ':')
+                {
+                    return fail("Expected ':'");
+                }
+
+                p_++;
+
+                if(!parseValue(value.members_.back().second, depth + 1))
+                {
+                    return false;
+                }
+
+                skipSpaces();
+
+                if(p_ < pEnd_ && *p_ == ',')
+                {
+                    p_++;
+                    continue;
+                }
+
+                if(p_ < pEnd_ && *p_ == '}')
+                {
+                    p_++;
+                    return true;
+                }
+
+                return fail("Expected ',' or '}'");
+            }
+
+        case '[':
+            value.type_ = JSON_ARRAY;
+            p_++;
+            skipSpaces();
+
+            if(p_ < pEnd_ && *p_ == ']')
+            {
+                p_++;
+                return true;
+            }
+
+            while(true)
+            {
+                value.elements_.emplace_back();
+
+                if(!parseValue(value.elements_.back(), depth + 1))
+                {
+                    return false;
+                }
+
+                skipSpaces();
+
+                if(p_ < pEnd_ && *p_ == ',')
+                {
+                    p_++;
+                    continue;
+                }
+
+                if(p_ < pEnd_ && *p_ == ']')
+                {
+                    p_++;
+                    return true;
+                }
+
+                return fail("Expected ',' or ']'");
+            }
+
+        case '"':
+            value.type_ = JSON_STRING;
+            return parseString(value.string_);
+
+        case 't':
+            value.type_ = JSON_BOOL;
+            value.boolean_ = true;
+            return expect("true");
+
+        case 'f':
+            value.type_ = JSON_BOOL;
+            value.boolean_ = false;
+            return expect("false");
+
+        case 'n':
+            value.type_ = JSON_NULL;
+            return expect("null");
+
+        default:
+            value.type_ = JSON_NUMBER;
+            return parseNumber(value.number_);
+        }
+    }
+
+public:
+    Parser(const char* pText, size_t size):
+        p_(pText),
+        pEnd_(pText + size),
+        pBegin_(pText)
+    {
+    }
+
+    bool parse(JsonValue& value, std::string& error)
+    {
+        //The byte order mark some editors write is not part of the value
+        if(pEnd_ - p_ >= 3 && memcmp(p_, "\xEF\xBB\xBF", 3) == 0)
+        {
+            p_ += 3;
+        }
+
+        bool isValid = parseValue(value, 0);
+        skipSpaces();
+
+        if(isValid && p_ != pEnd_)
+        {
+            isValid = fail("Unexpected text after the value");
+        }
+
+        error = error_;
+        return isValid;
+    }
+};
+
+bool JsonValue::parse(const char* pText, size_t size, JsonValue& value, std::string& error)
+{
+    value = JsonValue();
+    Parser parser(pText, size);
+    return parser.parse(value, error);
+}
+
+E_JsonType JsonValue::getType() const
+{
+    return type_;
+}
+
+bool JsonValue::isNull() const
+{
+    return type_ == JSON_NULL;
+}
+
+bool JsonValue::isArray() const
+{
+    return type_ == JSON_ARRAY;
+}
+
+bool JsonValue::isObject() const
+{
+    return type_ == JSON_OBJECT;
+}
+
+bool JsonValue::asBool(bool defaultValue) const
+{
+    return type_ == JSON_BOOL ? boolean_ : defaultValue;
+}
+
+double JsonValue::asNumber(double defaultValue) const
+{
+    return type_ == JSON_NUMBER ? number_ : defaultValue;
+}
+
+const std::string& JsonValue::asString() const
+{
+    return string_;
+}
+
+size_t JsonValue::size() const
+{
+    return type_ == JSON_ARRAY ? elements_.size() : type_ == JSON_OBJECT ? members_.size() : 0;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    return type_ == JSON_ARRAY && index < elements_.size() ? elements_[index] : NULL_VALUE;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& name) const
+{
+    for(const std::pair<std::string, JsonValue>& member : members_)
+    {
+        if(member.first == name)
+        {
+            return member.second;
+        }
+    }
+
+    return NULL_VALUE;
+}
+
+bool JsonValue::hasMember(const std::string& name) const
+{
+    return !(*this)[name].isNull();
+}
@@ -1,8 +1,15 @@
 #include "loader/Loader.h"
+#include "data/3D/MeshOptimizer.h"
+#include "data/3D/MeshSimplifier.h"
+#include "data/3D/NormalGenerator.h"
+#include "loader/ThreadPool.h"
+#include <chrono>
+#include <plog/Log.h>
 
 
 
-Loader::Loader()
+Loader::Loader():
+    normalCreaseAngle_(data::NO_CREASE_ANGLE)
 {
 
 }
@@ -12,3 +19,149 @@ Loader::~Loader()
 {
 
 }
+
+bool Loader::load(const std::string& path, std::vector<data::MeshPtr>& scene)
+{
+    std::vector<data::MeshPtr> meshes;
+    MeshCallback addMesh = [&meshes](const data::MeshPtr & mesh)
+    {
+        meshes.push_back(mesh);
+    };
+
+    if(!loadStreaming(path, addMesh))
+    {
+        return false;
+    }
+
+    scene.insert(scene.end(), meshes.begin(), meshes.end());
+    return true;
+}
+
+void Loader::setProgress(LoadProgress* pProgress)
+{
+    pProgress_ = pProgress;
+}
+
+bool Loader::isCancelled() const
+{
+    return pProgress_ && pProgress_->cancelled;
+}
+
+void Loader::setOptimizationEnabled(bool enabled)
+{
+    optimizationEnabled_ = enabled;
+}
+
+void Loader::setLodGenerationEnabled(bool enabled)
+{
+    lodGenerationEnabled_ = enabled;
+}
+
+void Loader::setNormalCreaseAngle(float angle)
+{
+    normalCreaseAngle_ = angle;
+}
+
+void Loader::processMesh(data::Mesh& mesh, ThreadPool* pPool)
+{
+    //Scans rarely come with normals, a black model is not an option. The point clouds have no face to
+    //get them from, they are drawn unlit
+    if(!mesh.indices.empty() && !data::hasNormals(mesh))
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        data::ParallelFor parallelFor;
+
+        //The small meshes are already processed in parallel with each other. No pool of its own : the
+        //loads running at once would each add as many threads as the processor has
+        if(pPool && mesh.indices.size() / 3 > data::NORMAL_BLOCK_SIZE)
+        {
+            parallelFor = [pPool](size_t count, const std::function<void(size_t)>& function)
+            {
+                pPool->parallelFor(count, function);
+            };
+        }
+
+        //Before the levels of detail, the creases may split vertices
+        data::generateNormals(mesh, normalCreaseAngle_, data::ANGLE_WEIGHTING, parallelFor);
+
+        PLOGD << "Normals of " << mesh.name << " generated in "
+              << std::chrono::duration<float, std::chrono::milliseconds::period>
+              (std::chrono::high_resolution_clock::now() - startTime).count() << " ms" << '\n';
+    }
+
+    //Point clouds : every vertex is drawn, there is no triangle to simplify or reorder
+    if(mesh.indices.empty())
+    {
+        return;
+    }
+
+    if(lodGenerationEnabled_ && mesh.indices.size() / 3 >= 2 * data::LOD_MIN_TRIANGLE_COUNT)
+    {
+        data::generateLods(mesh);
+
+        for(const data::MeshLod& lod : mesh.lods)
+        {
+            PLOGD << "Level of detail of " << mesh.name << " : " << lod.indices.size() / 3
+                  << " triangles, error " << lod.error << '\n';
+        }
+    }
+
+    if(!optimizationEnabled_)
+    {
+        return;
+    }
+
+    data::VertexCacheStats before = data::analyzeVertexCache(mesh);
+    data::VertexFetchStats fetchBefore = data::analyzeVertexFetch(mesh);
+    //Also reorders the levels of detail
+    data::optimizeVertexCache(mesh);
+    //The vertices are renumbered after the triangles are reordered, in the order they are now used
+    data::optimizeVertexFetch(mesh);
+    data::VertexCacheStats after = data::analyzeVertexCache(mesh);
+    data::VertexFetchStats fetchAfter = data::analyzeVertexFetch(mesh);
+
+    size_t triangleCount = mesh.indices.size() / 3;
+    optimizationTotals_.triangleCount += triangleCount;
+    optimizationTotals_.vertexCount += mesh.vertices.size();
+    optimizationTotals_.transformsBefore += static_cast<uint64_t>(before.acmr * triangleCount + 0.5f);
+    optimizationTotals_.transformsAfter += static_cast<uint64_t>(after.acmr * triangleCount + 0.5f);
+    optimizationTotals_.fetchedBytesBefore += static_cast<uint64_t>(fetchBefore.bytesPerTriangle *
+            triangleCount + 0.5f);
+    optimizationTotals_.fetchedBytesAfter += static_cast<uint64_t>(fetchAfter.bytesPerTriangle *
+            triangleCount + 0.5f);
+
+    PLOGD << "Vertex cache of " << mesh.name << " : ACMR " << before.acmr << " -> " << after.acmr
+          << ", ATVR " << before.atvr << " -> " << after.atvr << ", bytes fetched per triangle "
+          << fetchBefore.bytesPerTriangle << " -> " << fetchAfter.bytesPerTriangle << '\n';
+}
+
+void Loader::resetOptimizationTotals()
+{
+    optimizationTotals_.triangleCount = 0;
+    optimizationTotals_.vertexCount = 0;
+    optimizationTotals_.transformsBefore = 0;
+    optimizationTotals_.transformsAfter = 0;
+    optimizationTotals_.fetchedBytesBefore = 0;
+    optimizationTotals_.fetchedBytesAfter = 0;
+}
+
+void Loader::logOptimizationTotals(const std::string& path) const
+{
+    uint64_t triangleCount = optimizationTotals_.triangleCount;
+    uint64_t vertexCount = optimizationTotals_.vertexCount;
+
+    if(triangleCount == 0 || vertexCount == 0)
+    {
+        return;
+    }
+
+    //Weighted by the size of each mesh, a transform is a vertex shader invocation
+    PLOGI << "Vertex cache of " << path << " : ACMR "
+          << static_cast<float>(optimizationTotals_.transformsBefore) / triangleCount << " -> "
+          << static_cast<float>(optimizationTotals_.transformsAfter) / triangleCount << ", ATVR "
+          << static_cast<float>(optimizationTotals_.transformsBefore) / vertexCount << " -> "
+          << static_cast<float>(optimizationTotals_.transformsAfter) / vertexCount
+          << ", bytes fetched per triangle "
+          << static_cast<float>(optimizationTotals_.fetchedBytesBefore) / triangleCount << " -> "
+          << static_cast<float>(optimizationTotals_.fetchedBytesAfter) / triangleCount << '\n';
+}
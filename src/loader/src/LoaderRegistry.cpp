@@ -0,0 +1,150 @@
+#include "loader/LoaderRegistry.h"
+#include "loader/GltfLoader.h"
+#include "loader/ObjLoader.h"
+#include "loader/PlyLoader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <plog/Log.h>
+
+namespace
+{
+
+std::string getLowerExtension(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    size_t separator = path.find_last_of("/\\");
+
+    if(dot == std::string::npos || (separator != std::string::npos && dot < separator))
+    {
+        return std::string();
+    }
+
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+    {
+        return static_cast<char>(std::tolower(c));
+    });
+
+    return extension;
+}
+
+bool startsWith(const char* pHeader, size_t size, const char* signature)
+{
+    size_t length = strlen(signature);
+    return size >= length && memcmp(pHeader, signature, length) == 0;
+}
+
+}
+
+constexpr size_t LoaderRegistry::HEADER_SIZE;
+
+LoaderRegistry::LoaderRegistry()
+{
+
+}
+
+void LoaderRegistry::registerFormat(const std::string& name, const std::vector<std::string>& extensions,
+                                    const HeaderMatcher& matchHeader, const LoaderFactory& createLoader)
+{
+    formats_.push_back({ name, extensions, matchHeader, createLoader });
+}
+
+LoaderRegistry LoaderRegistry::createDefault()
+{
+    LoaderRegistry registry;
+
+    registry.registerFormat("glTF", { "gltf", "glb" }, [](const char* pHeader, size_t size)
+    {
+        //Binary container, or a json text : no other format read is json
+        const char* pText = pHeader;
+
+        while(pText < pHeader + size && isspace(static_cast<unsigned char>(*pText)))
+        {
+            pText++;
+        }
+
+        return startsWith(pHeader, size, "glTF") || (pText < pHeader + size && *pText == '{');
+    }, []()
+    {
+        return std::unique_ptr<Loader>(new GltfLoader());
+    });
+
+    registry.registerFormat("ply", { "ply" }, [](const char* pHeader, size_t size)
+    {
+        return startsWith(pHeader, size, "ply\n") || startsWith(pHeader, size, "ply\r\n");
+    }, []()
+    {
+        return std::unique_ptr<Loader>(new PlyLoader());
+    });
+
+    //Plain text without signature, only recognized by its extension
+    registry.registerFormat("obj", { "obj" }, nullptr, []()
+    {
+        return std::unique_ptr<Loader>(new ObjLoader());
+    });
+
+    return registry;
+}
+
+const LoaderRegistry::Format* LoaderRegistry::findFormat(const std::string& path) const
+{
+    char header[HEADER_SIZE];
+    std::ifstream file(path, std::ios::binary);
+    file.read(header, HEADER_SIZE);
+    size_t headerSize = static_cast<size_t>(file.gcount());
+
+    for(const Format& format : formats_)
+    {
+        if(format.matchHeader && format.matchHeader(header, headerSize))
+        {
+            return &format;
+        }
+    }
+
+    std::string extension = getLowerExtension(path);
+
+    for(const Format& format : formats_)
+    {
+        if(std::find(format.extensions.begin(), format.extensions.end(), extension) != format.extensions.end())
+        {
+            return &format;
+        }
+    }
+
+    return nullptr;
+}
+
+std::unique_ptr<Loader> LoaderRegistry::createLoader(const std::string& path) const
+{
+    const Format* pFormat = findFormat(path);
+
+    if(pFormat == nullptr)
+    {
+        PLOGE << "No loader for the format of " << path << '\n';
+        return nullptr;
+    }
+
+    PLOGD << path << " recognized as " << pFormat->name << '\n';
+    return pFormat->createLoader();
+}
+
+bool LoaderRegistry::hasKnownExtension(const std::string& path) const
+{
+    std::string extension = getLowerExtension(path);
+    std::vector<std::string> extensions = getExtensions();
+    return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+std::vector<std::string> LoaderRegistry::getExtensions() const
+{
+    std::vector<std::string> extensions;
+
+    for(const Format& format : formats_)
+    {
+        extensions.insert(extensions.end(), format.extensions.begin(), format.extensions.end());
+    }
+
+    return extensions;
+}
@@ -0,0 +1,225 @@
+#include "loader/MappedFile.h"
+#include <utility>
+#include <plog/Log.h>
+
+#ifdef WIN32_
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+    open(path);
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    if(this != &other)
+    {
+        close();
+        std::swap(pData_, other.pData_);
+        std::swap(size_, other.size_);
+#ifdef WIN32_
+        std::swap(fileHandle_, other.fileHandle_);
+        std::swap(mappingHandle_, other.mappingHandle_);
+#endif
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef WIN32_
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        PLOGE << "failed to open file : " << path << '\n';
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    fileHandle_ = file;
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+
+    //An empty file can't be mapped, it is still a valid empty view
+    if(size_ == 0)
+    {
+        return true;
+    }
+
+    mappingHandle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    pData_ = mappingHandle_ ? static_cast<const char*>(MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0,
+             0)) : nullptr;
+
+    if(pData_ == nullptr)
+    {
+        PLOGE << "failed to map file : " << path << '\n';
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(pData_)
+    {
+        UnmapViewOfFile(pData_);
+    }
+
+    if(mappingHandle_)
+    {
+        CloseHandle(mappingHandle_);
+    }
+
+    if(fileHandle_)
+    {
+        CloseHandle(fileHandle_);
+    }
+
+    pData_ = nullptr;
+    mappingHandle_ = nullptr;
+    fileHandle_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::release(size_t offset, size_t size) const
+{
+    //Unlocking pages that are not locked only drops them from the working set
+    if(pData_ && size)
+    {
+        VirtualUnlock(const_cast<char*>(pData_ + offset), size);
+    }
+}
+
+bool MappedFile::isOpen() const
+{
+    return fileHandle_ != nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if(fd < 0)
+    {
+        PLOGE << "failed to open file : " << path << '\n';
+        return false;
+    }
+
+    struct stat fileStat;
+
+    if(fstat(fd, &fileStat) != 0)
+    {
+        PLOGE << "failed to stat file : " << path << '\n';
+        ::close(fd);
+        return false;
+    }
+
+    size_ = static_cast<size_t>(fileStat.st_size);
+
+    if(size_ == 0)
+    {
+        //An empty file can't be mapped, it is still a valid empty view
+        ::close(fd);
+        pData_ = "";
+        return true;
+    }
+
+    void* pMapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    //The mapping keeps its own reference on the file
+    ::close(fd);
+
+    if(pMapped == MAP_FAILED)
+    {
+        PLOGE << "failed to map file : " << path << '\n';
+        size_ = 0;
+        return false;
+    }
+
+    madvise(pMapped, size_, MADV_SEQUENTIAL);
+    pData_ = static_cast<const char*>(pMapped);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(pData_ && size_)
+    {
+        munmap(const_cast<char*>(pData_), size_);
+    }
+
+    pData_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::release(size_t offset, size_t size) const
+{
+    if(pData_ == nullptr || size == 0)
+    {
+        return;
+    }
+
+    //madvise works on whole pages, only the pages fully inside the range are released
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+    size_t end = (offset + size) / pageSize * pageSize;
+
+    if(offset + size >= size_)
+    {
+        end = size_;
+    }
+
+    if(end > begin)
+    {
+        madvise(const_cast<char*>(pData_ + begin), end - begin, MADV_DONTNEED);
+    }
+}
+
+bool MappedFile::isOpen() const
+{
+    return pData_ != nullptr;
+}
+
+#endif
+
+const char* MappedFile::data() const
+{
+    return pData_;
+}
+
+size_t MappedFile::size() const
+{
+    return size_;
+}
@@ -0,0 +1,438 @@
+#include "loader/MeshCache.h"
+#include "loader/MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <plog/Log.h>
+
+#ifdef WIN32_
+#include <windows.h>
+#endif
+
+namespace
+{
+
+const char MAGIC[8] = { 'A', 'V', 'M', 'E', 'S', 'H', '\0', '\0' };
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t meshCount;
+    uint64_t fileSize;
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    //Settings the meshes were processed with
+    float normalCreaseAngle;
+    uint8_t optimizationEnabled;
+    uint8_t lodGenerationEnabled;
+    uint16_t padding;
+};
+
+struct MeshHeader
+{
+    uint64_t nameOffset;
+    uint64_t nameLength;
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t lodOffset;
+    uint64_t lodCount;
+    //The material name and texture path follow the name of the mesh
+    uint64_t materialNameLength;
+    uint64_t diffuseTextureLength;
+    float diffuseColor[3];
+    uint32_t padding;
+};
+
+struct LodHeader
+{
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    float error;
+    uint32_t padding;
+};
+
+static_assert(sizeof(FileHeader) == 48, "FileHeader must not contain padding");
+static_assert(sizeof(MeshHeader) == 96, "MeshHeader must not contain padding");
+static_assert(sizeof(LodHeader) == 24, "LodHeader must not contain padding");
+static_assert(sizeof(data::VertexAttribute) == 32, "VertexAttribute layout changed, bump the version");
+
+inline uint64_t rotateLeft(uint64_t value, int shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+uint64_t alignOffset(uint64_t offset, uint64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+bool isRangeValid(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+{
+    return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+//Whole triangles of the vertices of the mesh, the renderer reads the vertices without checking them
+bool areIndicesValid(const char* pIndices, uint64_t indexCount, uint64_t vertexCount)
+{
+    if(indexCount % 3 != 0)
+    {
+        return false;
+    }
+
+    for(uint64_t idx = 0; idx < indexCount; idx++)
+    {
+        uint32_t index;
+        memcpy(&index, pIndices + idx * sizeof(uint32_t), sizeof(uint32_t));
+
+        if(index >= vertexCount)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool replaceFile(const std::string& sourcePath, const std::string& destinationPath)
+{
+#ifdef WIN32_
+    return MoveFileExA(sourcePath.c_str(), destinationPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    //rename is atomic, the destination is either the previous cache or the new one
+    return std::rename(sourcePath.c_str(), destinationPath.c_str()) == 0;
+#endif
+}
+
+}
+
+const uint32_t MeshCache::VERSION = 6;
+const uint64_t MeshCache::DATA_ALIGNMENT = 256;
+const size_t MeshCache::HASH_BLOCK_SIZE = 1 << 16;
+
+std::string MeshCache::getCachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".avmesh";
+}
+
+uint64_t MeshCache::hashBlock(const char* pData, size_t size, uint64_t idxBlock)
+{
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    const uint64_t mixer = 0xBF58476D1CE4E5B9ull;
+
+    //4 independent lanes so the multiplications of consecutive words don't wait on each other
+    uint64_t seed = size ^ (idxBlock * mixer);
+    uint64_t lanes[4] = { seed, seed ^ 0xC2B2AE3D27D4EB4Full, ~seed, seed * prime };
+    size_t wordBlockCount = size / sizeof(lanes);
+
+    for(size_t idxWordBlock = 0; idxWordBlock < wordBlockCount; idxWordBlock++)
+    {
+        uint64_t words[4];
+        memcpy(words, pData + idxWordBlock * sizeof(words), sizeof(words));
+
+        for(int idxLane = 0; idxLane < 4; idxLane++)
+        {
+            lanes[idxLane] = rotateLeft(lanes[idxLane] ^ (words[idxLane] * prime), 31) * mixer;
+        }
+    }
+
+    for(size_t idx = wordBlockCount * sizeof(lanes); idx < size; idx++)
+    {
+        lanes[0] = (lanes[0] ^ static_cast<uint8_t>(pData[idx])) * prime;
+    }
+
+    uint64_t hash = lanes[0];
+
+    for(int idxLane = 1; idxLane < 4; idxLane++)
+    {
+        hash = (hash ^ rotateLeft(lanes[idxLane], idxLane * 16)) * prime;
+    }
+
+    hash ^= hash >> 31;
+    hash *= mixer;
+    return hash ^ (hash >> 29);
+}
+
+uint64_t MeshCache::combineBlockHashes(const std::vector<uint64_t>& blockHashes, size_t size)
+{
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = size * prime;
+
+    for(uint64_t blockHash : blockHashes)
+    {
+        hash = rotateLeft(hash ^ blockHash, 27) * prime;
+    }
+
+    return hash ^ (hash >> 32);
+}
+
+size_t MeshCache::getHashBlockCount(size_t size)
+{
+    return (size + HASH_BLOCK_SIZE - 1) / HASH_BLOCK_SIZE;
+}
+
+uint64_t MeshCache::hashContent(const char* pData, size_t size)
+{
+    std::vector<uint64_t> blockHashes(getHashBlockCount(size));
+
+    for(size_t idxBlock = 0; idxBlock < blockHashes.size(); idxBlock++)
+    {
+        size_t offset = idxBlock * HASH_BLOCK_SIZE;
+        blockHashes[idxBlock] = hashBlock(pData + offset, std::min(HASH_BLOCK_SIZE, size - offset), idxBlock);
+    }
+
+    return combineBlockHashes(blockHashes, size);
+}
+
+bool MeshCache::read(const std::string& cachePath, const MappedFile& source, const Settings& settings,
+                     const Loader::MeshCallback& onMesh)
+{
+    MappedFile cache;
+    std::ifstream exists(cachePath);
+
+    if(!exists.good())
+    {
+        return false;
+    }
+
+    exists.close();
+
+    if(!cache.open(cachePath) || cache.size() < sizeof(FileHeader))
+    {
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, cache.data(), sizeof(FileHeader));
+
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+       || header.fileSize != cache.size() || header.sourceSize != source.size())
+    {
+        PLOGI << "Outdated mesh cache ignored : " << cachePath << '\n';
+        return false;
+    }
+
+    if(header.optimizationEnabled != settings.optimizationEnabled
+       || header.lodGenerationEnabled != settings.lodGenerationEnabled
+       || header.normalCreaseAngle != settings.normalCreaseAngle)
+    {
+        PLOGI << "Mesh cache cooked with other loader settings ignored : " << cachePath << '\n';
+        return false;
+    }
+
+    //The modification time can stay the same after an edit (coarse timestamps, restored files), the
+    //content is always compared
+    if(header.sourceHash != hashContent(source.data(), source.size()))
+    {
+        PLOGI << "Mesh cache doesn't match the source anymore : " << cachePath << '\n';
+        return false;
+    }
+
+    if(!isRangeValid(sizeof(FileHeader), header.meshCount, sizeof(MeshHeader), cache.size()))
+    {
+        PLOGE << "Corrupted mesh cache : " << cachePath << '\n';
+        return false;
+    }
+
+    //Every header and index is checked before the first mesh is given, a corrupted cache gives nothing
+    std::vector<MeshHeader> meshHeaders(header.meshCount);
+    memcpy(meshHeaders.data(), cache.data() + sizeof(FileHeader), header.meshCount * sizeof(MeshHeader));
+
+    std::vector<std::vector<LodHeader>> lodHeaders(header.meshCount);
+
+    for(size_t idxMesh = 0; idxMesh < meshHeaders.size(); idxMesh++)
+    {
+        const MeshHeader& meshHeader = meshHeaders[idxMesh];
+
+        //Each length is bounded by the file size, their sum can't overflow
+        uint64_t textLength = meshHeader.nameLength + meshHeader.materialNameLength
+                              + meshHeader.diffuseTextureLength;
+
+        if(meshHeader.nameLength > cache.size() || meshHeader.materialNameLength > cache.size()
+           || meshHeader.diffuseTextureLength > cache.size()
+           || !isRangeValid(meshHeader.nameOffset, textLength, 1, cache.size())
+           || !isRangeValid(meshHeader.vertexOffset, meshHeader.vertexCount, sizeof(data::VertexAttribute),
+                            cache.size())
+           || !isRangeValid(meshHeader.indexOffset, meshHeader.indexCount, sizeof(uint32_t), cache.size())
+           || !isRangeValid(meshHeader.lodOffset, meshHeader.lodCount, sizeof(LodHeader), cache.size())
+           || !areIndicesValid(cache.data() + meshHeader.indexOffset, meshHeader.indexCount,
+                               meshHeader.vertexCount))
+        {
+            PLOGE << "Corrupted mesh cache : " << cachePath << '\n';
+            return false;
+        }
+
+        lodHeaders[idxMesh].resize(meshHeader.lodCount);
+        memcpy(lodHeaders[idxMesh].data(), cache.data() + meshHeader.lodOffset,
+               meshHeader.lodCount * sizeof(LodHeader));
+
+        for(const LodHeader& lodHeader : lodHeaders[idxMesh])
+        {
+            if(!isRangeValid(lodHeader.indexOffset, lodHeader.indexCount, sizeof(uint32_t), cache.size())
+               || !areIndicesValid(cache.data() + lodHeader.indexOffset, lodHeader.indexCount,
+                                   meshHeader.vertexCount))
+            {
+                PLOGE << "Corrupted mesh cache : " << cachePath << '\n';
+                return false;
+            }
+        }
+    }
+
+    for(size_t idxMesh = 0; idxMesh < meshHeaders.size(); idxMesh++)
+    {
+        const MeshHeader& meshHeader = meshHeaders[idxMesh];
+        data::Mesh mesh;
+        const char* pText = cache.data() + meshHeader.nameOffset;
+        mesh.name.assign(pText, meshHeader.nameLength);
+        pText += meshHeader.nameLength;
+        mesh.material.name.assign(pText, meshHeader.materialNameLength);
+        pText += meshHeader.materialNameLength;
+        mesh.material.diffuseTexture.assign(pText, meshHeader.diffuseTextureLength);
+        mesh.material.diffuseColor = glm::vec3(meshHeader.diffuseColor[0], meshHeader.diffuseColor[1],
+                                               meshHeader.diffuseColor[2]);
+        mesh.vertices.resize(meshHeader.vertexCount);
+        mesh.indices.resize(meshHeader.indexCount);
+        memcpy(mesh.vertices.data(), cache.data() + meshHeader.vertexOffset,
+               meshHeader.vertexCount * sizeof(data::VertexAttribute));
+        memcpy(mesh.indices.data(), cache.data() + meshHeader.indexOffset,
+               meshHeader.indexCount * sizeof(uint32_t));
+        mesh.lods.resize(meshHeader.lodCount);
+
+        for(size_t idxLod = 0; idxLod < mesh.lods.size(); idxLod++)
+        {
+            const LodHeader& lodHeader = lodHeaders[idxMesh][idxLod];
+            data::MeshLod& lod = mesh.lods[idxLod];
+            lod.error = lodHeader.error;
+            lod.indices.resize(lodHeader.indexCount);
+            memcpy(lod.indices.data(), cache.data() + lodHeader.indexOffset,
+                   lodHeader.indexCount * sizeof(uint32_t));
+        }
+
+        onMesh(std::make_shared<const data::Mesh>(std::move(mesh)));
+    }
+
+    return true;
+}
+
+bool MeshCache::write(const std::string& cachePath, size_t sourceSize, uint64_t sourceHash,
+                      const Settings& settings, const std::vector<data::MeshPtr>& scene)
+{
+    FileHeader header = {};
+    header.version = VERSION;
+    header.meshCount = static_cast<uint32_t>(scene.size());
+    header.sourceSize = sourceSize;
+    header.sourceHash = sourceHash;
+    header.normalCreaseAngle = settings.normalCreaseAngle;
+    header.optimizationEnabled = settings.optimizationEnabled;
+    header.lodGenerationEnabled = settings.lodGenerationEnabled;
+
+    //Compute the layout first, the headers are written before the data they describe
+    std::vector<MeshHeader> meshHeaders(scene.size());
+    std::vector<std::vector<LodHeader>> lodHeaders(scene.size());
+    uint64_t offset = sizeof(FileHeader) + scene.size() * sizeof(MeshHeader);
+
+    for(size_t idxMesh = 0; idxMesh < scene.size(); idxMesh++)
+    {
+        const data::Mesh& mesh = *scene[idxMesh];
+        MeshHeader& meshHeader = meshHeaders[idxMesh];
+
+        meshHeader.nameOffset = offset;
+        meshHeader.nameLength = mesh.name.size();
+        meshHeader.materialNameLength = mesh.material.name.size();
+        meshHeader.diffuseTextureLength = mesh.material.diffuseTexture.size();
+        meshHeader.diffuseColor[0] = mesh.material.diffuseColor.x;
+        meshHeader.diffuseColor[1] = mesh.material.diffuseColor.y;
+        meshHeader.diffuseColor[2] = mesh.material.diffuseColor.z;
+        meshHeader.padding = 0;
+        offset += mesh.name.size() + mesh.material.name.size() + mesh.material.diffuseTexture.size();
+
+        meshHeader.vertexOffset = alignOffset(offset, DATA_ALIGNMENT);
+        meshHeader.vertexCount = mesh.vertices.size();
+        offset = meshHeader.vertexOffset + mesh.vertices.size() * sizeof(data::VertexAttribute);
+
+        meshHeader.indexOffset = alignOffset(offset, DATA_ALIGNMENT);
+        meshHeader.indexCount = mesh.indices.size();
+        offset = meshHeader.indexOffset + mesh.indices.size() * sizeof(uint32_t);
+
+        meshHeader.lodOffset = alignOffset(offset, DATA_ALIGNMENT);
+        meshHeader.lodCount = mesh.lods.size();
+        offset = meshHeader.lodOffset + mesh.lods.size() * sizeof(LodHeader);
+        lodHeaders[idxMesh].resize(mesh.lods.size());
+
+        for(size_t idxLod = 0; idxLod < mesh.lods.size(); idxLod++)
+        {
+            LodHeader& lodHeader = lodHeaders[idxMesh][idxLod];
+            lodHeader.indexOffset = alignOffset(offset, DATA_ALIGNMENT);
+            lodHeader.indexCount = mesh.lods[idxLod].indices.size();
+            lodHeader.error = mesh.lods[idxLod].error;
+            lodHeader.padding = 0;
+            offset = lodHeader.indexOffset + lodHeader.indexCount * sizeof(uint32_t);
+        }
+    }
+
+    header.fileSize = offset;
+
+    //The cache is written next to its final path then renamed, a process reading the previous cache
+    //meanwhile keeps its mapping and an interrupted write never replaces it
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+    if(!file.is_open())
+    {
+        PLOGW << "Can't write the mesh cache : " << cachePath << '\n';
+        return false;
+    }
+
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    file.write(reinterpret_cast<const char*>(meshHeaders.data()), meshHeaders.size() * sizeof(MeshHeader));
+
+    const char padding[256] = {};
+    uint64_t position = sizeof(FileHeader) + meshHeaders.size() * sizeof(MeshHeader);
+
+    for(size_t idxMesh = 0; idxMesh < scene.size(); idxMesh++)
+    {
+        const data::Mesh& mesh = *scene[idxMesh];
+        const MeshHeader& meshHeader = meshHeaders[idxMesh];
+
+        file.write(mesh.name.data(), mesh.name.size());
+        file.write(mesh.material.name.data(), mesh.material.name.size());
+        file.write(mesh.material.diffuseTexture.data(), mesh.material.diffuseTexture.size());
+        position += mesh.name.size() + mesh.material.name.size() + mesh.material.diffuseTexture.size();
+        file.write(padding, meshHeader.vertexOffset - position);
+        file.write(reinterpret_cast<const char*>(mesh.vertices.data()),
+                   mesh.vertices.size() * sizeof(data::VertexAttribute));
+        position = meshHeader.vertexOffset + mesh.vertices.size() * sizeof(data::VertexAttribute);
+        file.write(padding, meshHeader.indexOffset - position);
+        file.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+        position = meshHeader.indexOffset + mesh.indices.size() * sizeof(uint32_t);
+
+        file.write(padding, meshHeader.lodOffset - position);
+        file.write(reinterpret_cast<const char*>(lodHeaders[idxMesh].data()),
+                   lodHeaders[idxMesh].size() * sizeof(LodHeader));
+        position = meshHeader.lodOffset + lodHeaders[idxMesh].size() * sizeof(LodHeader);
+
+        for(size_t idxLod = 0; idxLod < mesh.lods.size(); idxLod++)
+        {
+            const LodHeader& lodHeader = lodHeaders[idxMesh][idxLod];
+            file.write(padding, lodHeader.indexOffset - position);
+            file.write(reinterpret_cast<const char*>(mesh.lods[idxLod].indices.data()),
+                       lodHeader.indexCount * sizeof(uint32_t));
+            position = lodHeader.indexOffset + lodHeader.indexCount * sizeof(uint32_t);
+        }
+    }
+
+    file.close();
+
+    if(!file.good() || !replaceFile(tempPath, cachePath))
+    {
+        PLOGW << "Failed to write the mesh cache : " << cachePath << '\n';
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
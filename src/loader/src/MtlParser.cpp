@@ -0,0 +1,186 @@
+#include "loader/MtlParser.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <plog/Log.h>
+
+namespace
+{
+
+//Options of the texture statements and the number of values following each
+const std::pair<const char*, int> TEXTURE_OPTIONS[] =
+{
+    { "-blendu", 1 }, { "-blendv", 1 }, { "-boost", 1 }, { "-bm", 1 }, { "-cc", 1 }, { "-clamp", 1 },
+    { "-imfchan", 1 }, { "-texres", 1 }, { "-type", 1 }, { "-mm", 2 }, { "-o", 3 }, { "-s", 3 }, { "-t", 3 }
+};
+
+std::string trim(const std::string& text)
+{
+    size_t begin = text.find_first_not_of(" \t\r");
+
+    if(begin == std::string::npos)
+    {
+        return std::string();
+    }
+
+    return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+}
+
+bool isNumber(const std::string& token)
+{
+    char* pEnd;
+    strtod(token.c_str(), &pEnd);
+    return !token.empty() && *pEnd == '\0';
+}
+
+//Start of the next token from position, the end of the text if there is none
+size_t nextToken(const std::string& text, size_t position, std::string& token)
+{
+    size_t begin = text.find_first_not_of(" \t\r", position);
+
+    if(begin == std::string::npos)
+    {
+        token.clear();
+        return text.size();
+    }
+
+    size_t end = std::min(text.find_first_of(" \t\r", begin), text.size());
+    token = text.substr(begin, end - begin);
+    return begin;
+}
+
+/*@brief : File name of a texture statement, what follows the options. The name may contain spaces,
+*          the rest of the line is kept
+*/
+std::string parseTexturePath(const std::string& arguments)
+{
+    std::string token;
+    size_t position = nextToken(arguments, 0, token);
+
+    while(!token.empty())
+    {
+        auto itOption = std::find_if(std::begin(TEXTURE_OPTIONS), std::end(TEXTURE_OPTIONS),
+                                     [&token](const std::pair<const char*, int>& option)
+        {
+            return token == option.first;
+        });
+
+        if(itOption == std::end(TEXTURE_OPTIONS))
+        {
+            break;
+        }
+
+        position = nextToken(arguments, position + token.size(), token);
+
+        //The options with 3 values accept fewer, only the numbers following them are skipped
+        for(int idxValue = 0; idxValue < itOption->second && !token.empty(); idxValue++)
+        {
+            if(idxValue > 0 && itOption->second == 3 && !isNumber(token))
+            {
+                break;
+            }
+
+            position = nextToken(arguments, position + token.size(), token);
+        }
+    }
+
+    return trim(arguments.substr(position));
+}
+
+}
+
+std::string MtlParser::getDirectory(const std::string& path)
+{
+    size_t separator = path.find_last_of("/\\");
+    return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+}
+
+std::string MtlParser::resolvePath(const std::string& directory, const std::string& path)
+{
+    //Libraries exported on Windows often use backslashes, slashes are understood everywhere
+    std::string resolved = path;
+    std::replace(resolved.begin(), resolved.end(), '\\', '/');
+
+    if((!resolved.empty() && resolved[0] == '/') || (resolved.size() > 1 && resolved[1] == ':'))
+    {
+        return resolved;
+    }
+
+    return directory + resolved;
+}
+
+bool MtlParser::parse(const std::string& path, MaterialMap& materials)
+{
+    std::ifstream file(path);
+
+    if(!file.is_open())
+    {
+        PLOGW << "Can't open the material library : " << path << '\n';
+        return false;
+    }
+
+    std::string directory = getDirectory(path);
+    data::MaterialData* pMaterial = nullptr;
+    std::string line;
+
+    while(std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string keyword;
+
+        if(!(stream >> keyword) || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        std::string arguments;
+        std::getline(stream, arguments);
+
+        if(keyword == "newmtl")
+        {
+            std::string name = trim(arguments);
+            materials[name] = data::MaterialData();
+            pMaterial = &materials[name];
+            pMaterial->name = name;
+        }
+        else if(pMaterial == nullptr)
+        {
+            continue;
+        }
+        else if(keyword == "Kd")
+        {
+            std::istringstream values(arguments);
+            float components[3];
+            int componentCount = 0;
+
+            while(componentCount < 3 && values >> components[componentCount])
+            {
+                componentCount++;
+            }
+
+            //A single value is a grey level, "Kd spectral" and "Kd xyz" are not supported
+            if(componentCount == 1)
+            {
+                pMaterial->diffuseColor = glm::vec3(components[0]);
+            }
+            else if(componentCount == 3)
+            {
+                pMaterial->diffuseColor = glm::vec3(components[0], components[1], components[2]);
+            }
+        }
+        else if(keyword == "map_Kd")
+        {
+            std::string texturePath = parseTexturePath(arguments);
+
+            if(!texturePath.empty())
+            {
+                pMaterial->diffuseTexture = resolvePath(directory, texturePath);
+            }
+        }
+    }
+
+    PLOGD << "Material library " << path << " read, " << materials.size() << " materials known" << '\n';
+    return true;
+}
@@ -1,5 +1,8 @@
 #include "loader/ObjLoader.h"
-#include <algorithm>
+#include "data/3D/VertexWelder.h"
+#include "loader/MappedFile.h"
+#include "loader/MeshCache.h"
+#include <chrono>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <plog/Log.h>
@@ -10,7 +13,10 @@
 ObjLoader::ObjLoader(/* args */) :
     Loader()
 {
-
+    parser_.setMeshProcessor([this](data::Mesh & mesh, ThreadPool * pPool)
+    {
+        processMesh(mesh, pPool);
+    });
 }
 
 ObjLoader::~ObjLoader()
@@ -18,11 +24,123 @@ ObjLoader::~ObjLoader()
 
 }
 
-tinyobj::index_t findMinIndexes(const tinyobj::shape_t& shape);
-tinyobj::index_t findMaxIndexes(const tinyobj::shape_t& shape);
+void ObjLoader::setParser(E_ObjParser parserType)
+{
+    parserType_ = parserType;
+}
+
+void ObjLoader::setThreadCount(size_t count)
+{
+    parser_.setThreadCount(count);
+}
+
+void ObjLoader::setCacheEnabled(bool enabled)
+{
+    cacheEnabled_ = enabled;
+}
+
+void ObjLoader::setProgress(LoadProgress* pProgress)
+{
+    Loader::setProgress(pProgress);
+    parser_.setProgress(pProgress);
+}
+
+bool ObjLoader::loadStreaming(const std::string& path, const MeshCallback& onMesh)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    MappedFile file;
+
+    if(!file.open(path))
+    {
+        return false;
+    }
+
+    std::string cachePath = MeshCache::getCachePath(path);
+    MeshCache::Settings cacheSettings = { optimizationEnabled_, lodGenerationEnabled_, normalCreaseAngle_ };
+
+    if(pProgress_)
+    {
+        pProgress_->totalBytes = file.size();
+    }
+
+    MeshCallback onCachedMesh = [this, &onMesh](const data::MeshPtr & mesh)
+    {
+        if(pProgress_)
+        {
+            pProgress_->meshCount++;
+        }
+
+        onMesh(mesh);
+    };
+
+    if(cacheEnabled_ && MeshCache::read(cachePath, file, cacheSettings, onCachedMesh))
+    {
+        if(pProgress_)
+        {
+            pProgress_->parsedBytes = file.size();
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        PLOGI << path << " loaded from cache in "
+              << std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count()
+              << " ms" << '\n';
+        return true;
+    }
+
+    resetOptimizationTotals();
+
+    //The meshes are kept to write the cache once the whole file is loaded, they are shared, not copied
+    std::vector<data::MeshPtr> meshes;
+    MeshCallback onParsedMesh = [this, &onMesh, &meshes](const data::MeshPtr & mesh)
+    {
+        if(cacheEnabled_)
+        {
+            meshes.push_back(mesh);
+        }
+
+        onMesh(mesh);
+    };
+
+    //The native parser releases the pages of the file once parsed, it hashes them for the cache before
+    uint64_t contentHash = 0;
+    bool loaded = parserType_ == NATIVE_PARSER ?
+                  loadWithNativeParser(path, file, onParsedMesh, cacheEnabled_ ? &contentHash : nullptr) :
+                  loadWithTinyObj(path, onParsedMesh);
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    PLOGI << path << (parserType_ == NATIVE_PARSER ? " loaded by the native parser in " :
+                      " loaded by tinyobj in ")
+          << std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count()
+          << " ms" << '\n';
+
+    if(!loaded || isCancelled())
+    {
+        return false;
+    }
+
+    logOptimizationTotals(path);
+
+    if(cacheEnabled_)
+    {
+        if(parserType_ == TINYOBJ_PARSER)
+        {
+            contentHash = MeshCache::hashContent(file.data(), file.size());
+        }
+
+        MeshCache::write(cachePath, file.size(), contentHash, cacheSettings, meshes);
+    }
+
+    return true;
+}
+
+bool ObjLoader::loadWithNativeParser(const std::string& path, const MappedFile& file,
+                                     const MeshCallback& onMesh, uint64_t* pContentHash)
+{
+    parser_.setMaterialDirectory(MtlParser::getDirectory(path));
+    return parser_.parse(file, onMesh, pContentHash);
+}
 
-//TODO : Insert Materials
-bool ObjLoader::load(const std::string& path, std::vector<data::Mesh>& scene)
+bool ObjLoader::loadWithTinyObj(const std::string& path, const MeshCallback& onMesh)
 {
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
@@ -30,32 +148,58 @@ bool ObjLoader::load(const std::string& path, std::vector<data::Mesh>& scene)
 
     std::string err;
     std::string warn;
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
-
-    std::vector<data::Mesh> meshes;
+    std::string directory = MtlParser::getDirectory(path);
+    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), directory.c_str());
 
     if(!err.empty())
     {
         PLOGE << err.data() << '\n';
     }
 
-    if(!ret)
+    if(!ret || isCancelled())
     {
         return false;
     }
 
-    data::Mesh newMsh;
+    //tinyobj reads the whole file at once, the progress is only known once it returns
+    if(pProgress_)
+    {
+        pProgress_->parsedBytes = pProgress_->totalBytes.load();
+    }
+
+    data::VertexWelder welder;
+    size_t cornerCount = 0;
+    size_t vertexCount = 0;
+    //Only the welding of the corners, without the processing and the upload of the meshes
+    float weldTime = 0.0f;
 
     // Loop over shapes
-    for(tinyobj::shape_t shape : shapes)
+    for(const tinyobj::shape_t& shape : shapes)
     {
         size_t index_offset = 0;
 
-        uint32_t indexVertex = 0;
-
+        data::Mesh newMsh;
         newMsh.name = shape.name;
+        newMsh.indices.reserve(shape.mesh.indices.size());
+
+        //tinyobj keeps a shape using several materials whole, it is given the material of its first face
+        int materialId = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[0];
+
+        if(materialId >= 0 && materialId < static_cast<int>(materials.size()))
+        {
+            const tinyobj::material_t& material = materials[materialId];
+            newMsh.material.name = material.name;
+            newMsh.material.diffuseColor = glm::vec3(material.diffuse[0], material.diffuse[1], material.diffuse[2]);
+
+            if(!material.diffuse_texname.empty())
+            {
+                newMsh.material.diffuseTexture = MtlParser::resolvePath(directory, material.diffuse_texname);
+            }
+        }
 
-        data::VertexAttribute vertex;
+        //Corners sharing the same vertex/normal/texcoord triple are welded into a single vertex
+        auto startTime = std::chrono::high_resolution_clock::now();
+        welder.reset(shape.mesh.indices.size() / 2);
 
         for(size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++)
         {
@@ -64,9 +208,19 @@ bool ObjLoader::load(const std::string& path, std::vector<data::Mesh>& scene)
             for(int v = 0; v < fv; v++)
             {
                 tinyobj::index_t idx = shape.mesh.indices[index_offset + v];
+                data::VertexKey key = { idx.vertex_index, idx.normal_index, idx.texcoord_index };
+                bool inserted;
+                uint32_t indexVertex = welder.findOrInsert(key,
+                                       static_cast<uint32_t>(newMsh.vertices.size()), inserted);
+                newMsh.indices.push_back(indexVertex);
+
+                if(!inserted)
+                {
+                    continue;
+                }
+
                 size_t indexTemp;
-                data::VertexAttribute vertex;
-                memset(&vertex, 0, sizeof(data::VertexAttribute));
+                data::VertexAttribute vertex{};
 
                 if(idx.vertex_index > -1)
                 {
@@ -88,89 +242,36 @@ bool ObjLoader::load(const std::string& path, std::vector<data::Mesh>& scene)
                     vertex.texCoord = glm::vec2(attrib.texcoords[indexTemp], attrib.texcoords[indexTemp + 1]);
                 }
 
-                //TODO : If vertex not already in vertices
-                //add vertex to vertices
-                //else
-                //add an index to ebo
-
                 newMsh.vertices.push_back(vertex);
-                newMsh.indices.push_back(indexVertex);
-                indexVertex++;
             }
 
             index_offset += fv;
         }
 
-        scene.push_back(newMsh);
-    }
-
-    return true;
-}
+        weldTime += std::chrono::duration<float, std::chrono::milliseconds::period>
+                    (std::chrono::high_resolution_clock::now() - startTime).count();
+        cornerCount += newMsh.indices.size();
+        vertexCount += newMsh.vertices.size();
 
+        //Meshes processed one at a time, without a pool
+        processMesh(newMsh, nullptr);
 
+        if(pProgress_)
+        {
+            pProgress_->meshCount++;
+        }
 
-tinyobj::index_t findMinIndexes(const tinyobj::shape_t& shape)
-{
-    tinyobj::index_t idxTemp;
-    tinyobj::index_t minIdx;
-
-    //Look for minimum vertex index
-    idxTemp = *std::min_element(shape.mesh.indices.begin(),
-                                shape.mesh.indices.end(), [](const tinyobj::index_t& left, const tinyobj::index_t& right)
-    {
-        return left.vertex_index < right.vertex_index;
-    });
-    minIdx.vertex_index = idxTemp.vertex_index;
-
-    //Look for minimum normal index
-    idxTemp = *std::min_element(shape.mesh.indices.begin(),
-                                shape.mesh.indices.end(), [](const tinyobj::index_t& left, const tinyobj::index_t& right)
-    {
-        return left.normal_index < right.normal_index;
-    });
-    minIdx.normal_index = idxTemp.normal_index;
-
-    //Look for minimum texcoord_index index
-    //TODO : Is there an index per mesh for tex coord
-    idxTemp = *std::min_element(shape.mesh.indices.begin(),
-                                shape.mesh.indices.end(), [](const tinyobj::index_t& left, const tinyobj::index_t& right)
-    {
-        return left.texcoord_index < right.texcoord_index;
-    });
-    minIdx.texcoord_index = idxTemp.texcoord_index;
-
-    return minIdx;
-}
-
-tinyobj::index_t findMaxIndexes(const tinyobj::shape_t& shape)
-{
-    tinyobj::index_t idxTemp;
-    tinyobj::index_t maxIdx;
-
-    //Look for maximum vertex index
-    idxTemp = *std::max_element(shape.mesh.indices.begin(),
-                                shape.mesh.indices.end(), [](const tinyobj::index_t& left, const tinyobj::index_t& right)
-    {
-        return left.vertex_index < right.vertex_index;
-    });
-    maxIdx.vertex_index = idxTemp.vertex_index;
+        onMesh(std::make_shared<const data::Mesh>(std::move(newMsh)));
 
-    //Look for maximum normal index
-    idxTemp = *std::max_element(shape.mesh.indices.begin(),
-                                shape.mesh.indices.end(), [](const tinyobj::index_t& left, const tinyobj::index_t& right)
-    {
-        return left.normal_index < right.normal_index;
-    });
-    maxIdx.normal_index = idxTemp.normal_index;
+        if(isCancelled())
+        {
+            return false;
+        }
+    }
 
-    //Look for maximum texcoord_index index
-    //TODO : Is there an index per mesh for tex coord
-    idxTemp = *std::max_element(shape.mesh.indices.begin(),
-                                shape.mesh.indices.end(), [](const tinyobj::index_t& left, const tinyobj::index_t& right)
-    {
-        return left.texcoord_index < right.texcoord_index;
-    });
-    maxIdx.texcoord_index = idxTemp.texcoord_index;
+    PLOGI << "Vertex welding : " << cornerCount << " corners -> " << vertexCount << " vertices (ratio "
+          << (vertexCount ? static_cast<float>(cornerCount) / vertexCount : 0.0f) << ") in "
+          << weldTime << " ms" << '\n';
 
-    return maxIdx;
+    return true;
 }
@@ -0,0 +1,763 @@
+#include "loader/ObjParser.h"
+#include "loader/LoadProgress.h"
+#include "loader/MappedFile.h"
+#include "loader/MeshCache.h"
+#include "loader/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <plog/Log.h>
+
+namespace
+{
+
+const double POWERS_OF_TEN[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipSpaces(const char* p, const char* pEnd)
+{
+    while(p < pEnd && isSpace(*p))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+inline const char* parseInt(const char* p, const char* pEnd, int32_t& value)
+{
+    bool negative = false;
+
+    if(p < pEnd && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    int32_t result = 0;
+
+    while(p < pEnd && isDigit(*p))
+    {
+        result = result * 10 + (*p - '0');
+        p++;
+    }
+
+    value = negative ? -result : result;
+    return p;
+}
+
+/*@brief : Parse a decimal float without going through the locale aware strtof
+*          The 19 first significant digits are accumulated in an integer, scaled once at the end
+*/
+const char* parseFloat(const char* p, const char* pEnd, float& value)
+{
+    const char* pStart = p;
+    bool negative = false;
+
+    if(p < pEnd && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+    int32_t significantDigits = 0;
+    bool hasDigits = false;
+
+    for(; p < pEnd && isDigit(*p); p++)
+    {
+        hasDigits = true;
+
+        if(significantDigits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            significantDigits += mantissa != 0;
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+
+    if(p < pEnd && *p == '.')
+    {
+        p++;
+
+        for(; p < pEnd && isDigit(*p); p++)
+        {
+            hasDigits = true;
+
+            if(significantDigits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                significantDigits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+
+    if(!hasDigits)
+    {
+        //nan, inf or garbage, let the standard library deal with it
+        char buffer[32] = {};
+        size_t length = std::min<size_t>(pEnd - pStart, sizeof(buffer) - 1);
+        memcpy(buffer, pStart, length);
+        char* pParsedEnd;
+        value = strtof(buffer, &pParsedEnd);
+        return pStart + (pParsedEnd - buffer);
+    }
+
+    if(p < pEnd && (*p == 'e' || *p == 'E'))
+    {
+        int32_t exponentValue;
+        p = parseInt(p + 1, pEnd, exponentValue);
+        exponent += exponentValue;
+    }
+
+    double result = static_cast<double>(mantissa);
+
+    if(exponent > 0)
+    {
+        result *= exponent <= 22 ? POWERS_OF_TEN[exponent] : std::pow(10.0, exponent);
+    }
+    else if(exponent < 0)
+    {
+        result /= -exponent <= 22 ? POWERS_OF_TEN[-exponent] : std::pow(10.0, -exponent);
+    }
+
+    value = static_cast<float>(negative ? -result : result);
+    return p;
+}
+
+//Rest of the line without the surrounding spaces
+std::string parseName(const char* p, const char* pEnd)
+{
+    p = skipSpaces(p, pEnd);
+
+    while(pEnd > p && isSpace(pEnd[-1]))
+    {
+        pEnd--;
+    }
+
+    return std::string(p, pEnd);
+}
+
+inline const char* parseFloats(const char* p, const char* pEnd, size_t count,
+                               std::vector<float>& values)
+{
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        float value = 0.0f;
+        p = skipSpaces(p, pEnd);
+
+        if(p < pEnd)
+        {
+            p = parseFloat(p, pEnd, value);
+        }
+
+        values.push_back(value);
+    }
+
+    return p;
+}
+
+}
+
+ObjParser::ObjParser()
+{
+
+}
+
+void ObjParser::setThreadCount(size_t count)
+{
+    threadCount_ = count;
+}
+
+size_t ObjParser::getThreadCount() const
+{
+    return threadCount_;
+}
+
+void ObjParser::setProgress(LoadProgress* pProgress)
+{
+    pProgress_ = pProgress;
+}
+
+void ObjParser::setMeshProcessor(const std::function<void(data::Mesh& mesh, ThreadPool* pPool)>& processor)
+{
+    meshProcessor_ = processor;
+}
+
+void ObjParser::setMaterialDirectory(const std::string& directory)
+{
+    materialDirectory_ = directory;
+}
+
+void ObjParser::parseFace(const char* p, const char* pEnd, Chunk& chunk,
+                          std::vector<data::VertexKey>& polygon, std::vector<uint8_t>& relativeMasks)
+{
+    //Attribute counts of the chunk, used to resolve the negative (relative) indices
+    int32_t counts[3] =
+    {
+        static_cast<int32_t>(chunk.positions.size() / 3),
+        static_cast<int32_t>(chunk.texCoords.size() / 2),
+        static_cast<int32_t>(chunk.normals.size() / 3)
+    };
+
+    polygon.clear();
+    relativeMasks.clear();
+
+    while((p = skipSpaces(p, pEnd)) < pEnd)
+    {
+        //Indices are written in the v/vt/vn order
+        int32_t indices[3] = { 0, 0, 0 };
+        uint8_t relativeMask = 0;
+
+        for(int attribute = 0; attribute < 3; attribute++)
+        {
+            if(attribute > 0)
+            {
+                if(p >= pEnd || *p != '/')
+                {
+                    break;
+                }
+
+                p++;
+            }
+
+            if(p < pEnd && (*p == '-' || isDigit(*p)))
+            {
+                p = parseInt(p, pEnd, indices[attribute]);
+            }
+        }
+
+        for(int attribute = 0; attribute < 3; attribute++)
+        {
+            if(indices[attribute] > 0)
+            {
+                indices[attribute]--;
+            }
+            else if(indices[attribute] < 0)
+            {
+                indices[attribute] += counts[attribute];
+                relativeMask |= 1 << attribute;
+            }
+            else
+            {
+                indices[attribute] = -1;
+            }
+        }
+
+        //Skip anything left in the token
+        while(p < pEnd && !isSpace(*p))
+        {
+            p++;
+        }
+
+        data::VertexKey corner = { indices[0], indices[2], indices[1] };
+        polygon.push_back(corner);
+        relativeMasks.push_back(relativeMask);
+    }
+
+    for(size_t idx = 1; idx + 1 < polygon.size(); idx++)
+    {
+        const size_t fan[3] = { 0, idx, idx + 1 };
+
+        for(size_t corner : fan)
+        {
+            uint8_t relativeMask = relativeMasks[corner];
+
+            if(relativeMask & 1)
+            {
+                chunk.relativeIndices.push_back({ chunk.corners.size(), &data::VertexKey::vertex });
+            }
+
+            if(relativeMask & 2)
+            {
+                chunk.relativeIndices.push_back({ chunk.corners.size(), &data::VertexKey::texCoord });
+            }
+
+            if(relativeMask & 4)
+            {
+                chunk.relativeIndices.push_back({ chunk.corners.size(), &data::VertexKey::normal });
+            }
+
+            chunk.corners.push_back(polygon[corner]);
+        }
+    }
+}
+
+bool ObjParser::parseChunk(Chunk& chunk, LoadProgress* pProgress)
+{
+    std::vector<data::VertexKey> polygon;
+    std::vector<uint8_t> relativeMasks;
+    const char* p = chunk.begin;
+    const char* pReported = chunk.begin;
+
+    while(p < chunk.end)
+    {
+        if(pProgress && static_cast<size_t>(p - pReported) >= PROGRESS_STEP)
+        {
+            pProgress->parsedBytes += p - pReported;
+            pReported = p;
+
+            if(pProgress->cancelled)
+            {
+                return false;
+            }
+        }
+
+        const char* pLineEnd = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+
+        if(pLineEnd == nullptr)
+        {
+            pLineEnd = chunk.end;
+        }
+
+        p = skipSpaces(p, pLineEnd);
+
+        if(pLineEnd - p >= 2)
+        {
+            bool separated = isSpace(p[1]);
+
+            if(p[0] == 'v' && separated)
+            {
+                parseFloats(p + 2, pLineEnd, 3, chunk.positions);
+            }
+            else if(p[0] == 'v' && p[1] == 'n' && pLineEnd - p >= 3 && isSpace(p[2]))
+            {
+                parseFloats(p + 3, pLineEnd, 3, chunk.normals);
+            }
+            else if(p[0] == 'v' && p[1] == 't' && pLineEnd - p >= 3 && isSpace(p[2]))
+            {
+                parseFloats(p + 3, pLineEnd, 2, chunk.texCoords);
+            }
+            else if(p[0] == 'f' && separated)
+            {
+                parseFace(p + 2, pLineEnd, chunk, polygon, relativeMasks);
+            }
+            else if((p[0] == 'o' || p[0] == 'g') && separated)
+            {
+                chunk.shapes.push_back({ chunk.corners.size() / 3, parseName(p + 2, pLineEnd), false });
+            }
+            else if(pLineEnd - p > 7 && memcmp(p, "usemtl", 6) == 0 && isSpace(p[6]))
+            {
+                chunk.shapes.push_back({ chunk.corners.size() / 3, parseName(p + 7, pLineEnd), true });
+            }
+            else if(pLineEnd - p > 7 && memcmp(p, "mtllib", 6) == 0 && isSpace(p[6]))
+            {
+                chunk.materialLibraries.push_back(parseName(p + 7, pLineEnd));
+            }
+        }
+
+        p = pLineEnd + 1;
+    }
+
+    if(pProgress)
+    {
+        pProgress->parsedBytes += chunk.end - pReported;
+    }
+
+    return true;
+}
+
+std::vector<ObjParser::Shape> ObjParser::gatherShapes(const std::vector<Chunk>& chunks)
+{
+    //Faces written before any "o", "g" or "usemtl" statement belong to an unnamed shape without material
+    std::vector<Shape> shapes(1);
+
+    for(const Chunk& chunk : chunks)
+    {
+        size_t segmentStart = 0;
+
+        for(const ShapeMarker& marker : chunk.shapes)
+        {
+            if(marker.firstTriangle > segmentStart)
+            {
+                shapes.back().segments.push_back({ &chunk, segmentStart, marker.firstTriangle });
+                segmentStart = marker.firstTriangle;
+            }
+
+            //The material stays the same across groups, the group across materials
+            std::string name = marker.isMaterial ? shapes.back().name : marker.name;
+            std::string material = marker.isMaterial ? marker.name : shapes.back().material;
+
+            if(shapes.back().segments.empty())
+            {
+                shapes.back().name = name;
+                shapes.back().material = material;
+            }
+            else if(name != shapes.back().name || material != shapes.back().material)
+            {
+                shapes.push_back({ name, material, {} });
+            }
+        }
+
+        size_t triangleCount = chunk.corners.size() / 3;
+
+        if(triangleCount > segmentStart)
+        {
+            shapes.back().segments.push_back({ &chunk, segmentStart, triangleCount });
+        }
+    }
+
+    if(shapes.back().segments.empty())
+    {
+        shapes.pop_back();
+    }
+
+    return shapes;
+}
+
+MtlParser::MaterialMap ObjParser::readMaterialLibraries(const std::vector<Chunk>& chunks) const
+{
+    MtlParser::MaterialMap materials;
+
+    for(const Chunk& chunk : chunks)
+    {
+        for(const std::string& library : chunk.materialLibraries)
+        {
+            //Several libraries can be listed in one statement, unless it is a single name with spaces
+            if(std::ifstream(materialDirectory_ + library).good())
+            {
+                MtlParser::parse(materialDirectory_ + library, materials);
+                continue;
+            }
+
+            std::istringstream names(library);
+            std::string name;
+
+            while(names >> name)
+            {
+                MtlParser::parse(materialDirectory_ + name, materials);
+            }
+        }
+    }
+
+    return materials;
+}
+
+bool ObjParser::buildMesh(const Shape& shape, const std::vector<float>& positions,
+                          const std::vector<float>& normals, const std::vector<float>& texCoords, data::Mesh& mesh)
+{
+    const int32_t positionCount = static_cast<int32_t>(positions.size() / 3);
+    const int32_t normalCount = static_cast<int32_t>(normals.size() / 3);
+    const int32_t texCoordCount = static_cast<int32_t>(texCoords.size() / 2);
+
+    size_t cornerCount = 0;
+
+    for(const ShapeSegment& segment : shape.segments)
+    {
+        cornerCount += (segment.lastTriangle - segment.firstTriangle) * 3;
+    }
+
+    mesh.name = shape.name;
+    mesh.indices.reserve(cornerCount);
+    data::VertexWelder welder(cornerCount / 2);
+
+    for(const ShapeSegment& segment : shape.segments)
+    {
+        for(size_t idxCorner = segment.firstTriangle * 3; idxCorner < segment.lastTriangle * 3; idxCorner++)
+        {
+            const data::VertexKey& key = segment.chunk->corners[idxCorner];
+
+            if(key.vertex < 0 || key.vertex >= positionCount || key.normal >= normalCount
+               || key.texCoord >= texCoordCount)
+            {
+                PLOGE << "Face index out of range in shape : " << shape.name << '\n';
+                return false;
+            }
+
+            bool inserted;
+            uint32_t indexVertex = welder.findOrInsert(key, static_cast<uint32_t>(mesh.vertices.size()),
+                                   inserted);
+            mesh.indices.push_back(indexVertex);
+
+            if(!inserted)
+            {
+                continue;
+            }
+
+            data::VertexAttribute vertex{};
+
+            //Same axis convention as the tinyobj path, the obj Y up becomes Z up
+            size_t indexTemp = key.vertex * 3;
+            vertex.pos = glm::vec3(positions[indexTemp], -positions[indexTemp + 2],
+                                   positions[indexTemp + 1]);
+
+            if(key.normal > -1)
+            {
+                indexTemp = key.normal * 3;
+                vertex.normal = glm::vec3(normals[indexTemp], -normals[indexTemp + 2],
+                                          normals[indexTemp + 1]);
+            }
+
+            if(key.texCoord > -1)
+            {
+                indexTemp = key.texCoord * 2;
+                vertex.texCoord = glm::vec2(texCoords[indexTemp], texCoords[indexTemp + 1]);
+            }
+
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    return true;
+}
+
+bool ObjParser::parse(const char* pData, size_t size, std::vector<data::MeshPtr>& scene)
+{
+    std::vector<data::MeshPtr> meshes;
+    Loader::MeshCallback addMesh = [&meshes](const data::MeshPtr & mesh)
+    {
+        meshes.push_back(mesh);
+    };
+
+    if(!parseText(pData, size, nullptr, addMesh, nullptr))
+    {
+        return false;
+    }
+
+    scene.insert(scene.end(), meshes.begin(), meshes.end());
+    return true;
+}
+
+bool ObjParser::parse(const MappedFile& file, const Loader::MeshCallback& onMesh, uint64_t* pContentHash)
+{
+    return parseText(file.data(), file.size(), &file, onMesh, pContentHash);
+}
+
+bool ObjParser::parseText(const char* pData, size_t size, const MappedFile* pFile,
+                          const Loader::MeshCallback& onMesh, uint64_t* pContentHash)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    ThreadPool pool(threadCount_);
+
+    //Split the text in chunks starting at the beginning of a line
+    size_t chunkCount = std::max<size_t>(1, std::min(size / MIN_CHUNK_SIZE, pool.size() * 4));
+    std::vector<Chunk> chunks(chunkCount);
+    const char* pEnd = pData + size;
+
+    for(size_t idx = 0; idx < chunkCount; idx++)
+    {
+        const char* pBegin = pData + size * idx / chunkCount;
+
+        if(idx > 0)
+        {
+            pBegin = static_cast<const char*>(memchr(pBegin, '\n', pEnd - pBegin));
+            pBegin = pBegin ? std::max(pBegin + 1, chunks[idx - 1].begin) : pEnd;
+        }
+
+        chunks[idx].begin = pBegin;
+
+        if(idx > 0)
+        {
+            chunks[idx - 1].end = pBegin;
+        }
+    }
+
+    chunks.back().end = pEnd;
+
+    std::atomic<bool> isCancelled(false);
+    std::vector<uint64_t> blockHashes(pContentHash ? MeshCache::getHashBlockCount(size) : 0);
+
+    pool.parallelFor(chunkCount, [&](size_t idx)
+    {
+        if(isCancelled || !parseChunk(chunks[idx], pProgress_))
+        {
+            isCancelled = true;
+            return;
+        }
+
+        //The blocks starting in the chunk are hashed while its pages are still loaded, the last one
+        //may read the few first pages of the next chunk
+        if(pContentHash)
+        {
+            const size_t blockSize = MeshCache::HASH_BLOCK_SIZE;
+            size_t firstBlock = (chunks[idx].begin - pData + blockSize - 1) / blockSize;
+            size_t endBlock = (chunks[idx].end - pData + blockSize - 1) / blockSize;
+
+            for(size_t idxBlock = firstBlock; idxBlock < endBlock; idxBlock++)
+            {
+                size_t offset = idxBlock * blockSize;
+                blockHashes[idxBlock] = MeshCache::hashBlock(pData + offset, std::min(blockSize, size - offset),
+                                        idxBlock);
+            }
+        }
+
+        //Nothing references the text after the parsing, the names are copied
+        if(pFile)
+        {
+            pFile->release(chunks[idx].begin - pData, chunks[idx].end - chunks[idx].begin);
+        }
+    });
+
+    if(isCancelled)
+    {
+        PLOGI << "Obj parsing cancelled" << '\n';
+        return false;
+    }
+
+    if(pContentHash)
+    {
+        *pContentHash = MeshCache::combineBlockHashes(blockHashes, size);
+    }
+
+    auto parseTime = std::chrono::high_resolution_clock::now();
+
+    //Offsets of each chunk attributes in the whole file
+    std::vector<size_t> positionOffsets(chunkCount + 1, 0);
+    std::vector<size_t> normalOffsets(chunkCount + 1, 0);
+    std::vector<size_t> texCoordOffsets(chunkCount + 1, 0);
+
+    for(size_t idx = 0; idx < chunkCount; idx++)
+    {
+        positionOffsets[idx + 1] = positionOffsets[idx] + chunks[idx].positions.size();
+        normalOffsets[idx + 1] = normalOffsets[idx] + chunks[idx].normals.size();
+        texCoordOffsets[idx + 1] = texCoordOffsets[idx] + chunks[idx].texCoords.size();
+    }
+
+    std::vector<float> positions(positionOffsets.back());
+    std::vector<float> normals(normalOffsets.back());
+    std::vector<float> texCoords(texCoordOffsets.back());
+
+    pool.parallelFor(chunkCount, [&](size_t idx)
+    {
+        Chunk& chunk = chunks[idx];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + positionOffsets[idx]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalOffsets[idx]);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(),
+                  texCoords.begin() + texCoordOffsets[idx]);
+        std::vector<float>().swap(chunk.positions);
+        std::vector<float>().swap(chunk.normals);
+        std::vector<float>().swap(chunk.texCoords);
+
+        for(const RelativeIndex& relative : chunk.relativeIndices)
+        {
+            int32_t& index = chunk.corners[relative.corner].*relative.attribute;
+
+            if(relative.attribute == &data::VertexKey::vertex)
+            {
+                index += static_cast<int32_t>(positionOffsets[idx] / 3);
+            }
+            else if(relative.attribute == &data::VertexKey::normal)
+            {
+                index += static_cast<int32_t>(normalOffsets[idx] / 3);
+            }
+            else
+            {
+                index += static_cast<int32_t>(texCoordOffsets[idx] / 2);
+            }
+
+            //Still negative : refers to an attribute declared before the beginning of the file
+            if(index < 0)
+            {
+                index = std::numeric_limits<int32_t>::max();
+            }
+        }
+    });
+
+    std::vector<Shape> shapes = gatherShapes(chunks);
+    MtlParser::MaterialMap materials = readMaterialLibraries(chunks);
+    std::vector<data::Mesh> meshes(shapes.size());
+    std::atomic<bool> isValid(true);
+
+    //The meshes are given in the order of the file as soon as all the previous ones are built
+    std::mutex emitMutex;
+    std::vector<uint8_t> isBuilt(shapes.size(), 0);
+    size_t nextMesh = 0;
+    size_t cornerCount = 0;
+    size_t vertexCount = 0;
+
+    pool.parallelFor(shapes.size(), [&](size_t idx)
+    {
+        if(!isValid || (pProgress_ && pProgress_->cancelled))
+        {
+            isValid = false;
+            return;
+        }
+
+        if(!buildMesh(shapes[idx], positions, normals, texCoords, meshes[idx]))
+        {
+            isValid = false;
+            return;
+        }
+
+        if(!shapes[idx].material.empty())
+        {
+            auto itMaterial = materials.find(shapes[idx].material);
+
+            //A material missing from the libraries keeps the default color, under its name
+            if(itMaterial != materials.end())
+            {
+                meshes[idx].material = itMaterial->second;
+            }
+            else
+            {
+                meshes[idx].material.name = shapes[idx].material;
+            }
+        }
+
+        if(meshProcessor_)
+        {
+            meshProcessor_(meshes[idx], &pool);
+        }
+
+        std::lock_guard<std::mutex> lock(emitMutex);
+        isBuilt[idx] = 1;
+
+        while(isValid && nextMesh < meshes.size() && isBuilt[nextMesh])
+        {
+            data::Mesh& mesh = meshes[nextMesh++];
+            cornerCount += mesh.indices.size();
+            vertexCount += mesh.vertices.size();
+
+            if(pProgress_)
+            {
+                pProgress_->meshCount++;
+            }
+
+            //The arrays are moved, not copied, in the shared mesh
+            onMesh(std::make_shared<const data::Mesh>(std::move(mesh)));
+            mesh = data::Mesh();
+        }
+    });
+
+    if(!isValid)
+    {
+        return false;
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    PLOGI << "Obj parsed with " << pool.size() << " threads in " << chunkCount << " chunks : parsing "
+          << std::chrono::duration<float, std::chrono::milliseconds::period>(parseTime - startTime).count()
+          << " ms, merging and welding "
+          << std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - parseTime).count()
+          << " ms, " << cornerCount << " corners -> " << vertexCount << " vertices" << '\n';
+
+    return true;
+}
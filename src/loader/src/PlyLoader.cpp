@@ -0,0 +1,816 @@
+#include "loader/PlyLoader.h"
+#include "loader/MappedFile.h"
+#include "loader/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <sstream>
+#include <plog/Log.h>
+
+//Only the shuffles of swapWordsSsse3 are compiled for SSSE3, chosen at runtime on the processors supporting it
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <tmmintrin.h>
+#define PLY_SSSE3_SWAP
+#define PLY_SSSE3_TARGET __attribute__((target("ssse3")))
+#define PLY_HAS_SSSE3() __builtin_cpu_supports("ssse3")
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <tmmintrin.h>
+#define PLY_SSSE3_SWAP
+#define PLY_SSSE3_TARGET
+#define PLY_HAS_SSSE3() true
+#endif
+
+namespace
+{
+
+//Vertices converted at once, also the size of the point meshes
+const size_t PLY_BLOCK_SIZE = 1 << 20;
+//Faces read between two releases of the pages already read
+const size_t FACE_BLOCK_SIZE = 1 << 20;
+const uint32_t NO_PROPERTY = 0xFFFFFFFF;
+
+enum E_PlyType
+{
+    PLY_INVALID,
+    PLY_INT8,
+    PLY_UINT8,
+    PLY_INT16,
+    PLY_UINT16,
+    PLY_INT32,
+    PLY_UINT32,
+    PLY_FLOAT32,
+    PLY_FLOAT64
+};
+
+struct PlyProperty
+{
+    std::string name;
+    E_PlyType type = PLY_INVALID;
+    //Type of the element count of a list, PLY_INVALID if the property is a scalar
+    E_PlyType countType = PLY_INVALID;
+    //Offset in the record, only meaningful if the element has no list
+    size_t offset = 0;
+};
+
+struct PlyElement
+{
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+    //0 if the records have lists, their size then varies
+    size_t recordSize = 0;
+};
+
+//Properties of the vertex element read into data::VertexAttribute, in its order
+struct VertexLayout
+{
+    uint32_t properties[8];
+};
+
+E_PlyType parseType(const std::string& name)
+{
+    if(name == "char" || name == "int8")
+    {
+        return PLY_INT8;
+    }
+
+    if(name == "uchar" || name == "uint8")
+    {
+        return PLY_UINT8;
+    }
+
+    if(name == "short" || name == "int16")
+    {
+        return PLY_INT16;
+    }
+
+    if(name == "ushort" || name == "uint16")
+    {
+        return PLY_UINT16;
+    }
+
+    if(name == "int" || name == "int32")
+    {
+        return PLY_INT32;
+    }
+
+    if(name == "uint" || name == "uint32")
+    {
+        return PLY_UINT32;
+    }
+
+    if(name == "float" || name == "float32")
+    {
+        return PLY_FLOAT32;
+    }
+
+    if(name == "double" || name == "float64")
+    {
+        return PLY_FLOAT64;
+    }
+
+    return PLY_INVALID;
+}
+
+size_t getTypeSize(E_PlyType type)
+{
+    static const size_t SIZES[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+    return SIZES[type];
+}
+
+//Value of a scalar already in the byte order of the host
+double readValue(const char* pData, E_PlyType type)
+{
+    switch(type)
+    {
+    case PLY_INT8:
+        return static_cast<int8_t>(*pData);
+
+    case PLY_UINT8:
+        return static_cast<uint8_t>(*pData);
+
+    case PLY_INT16:
+    {
+        int16_t value;
+        memcpy(&value, pData, sizeof(value));
+        return value;
+    }
+
+    case PLY_UINT16:
+    {
+        uint16_t value;
+        memcpy(&value, pData, sizeof(value));
+        return value;
+    }
+
+    case PLY_INT32:
+    {
+        int32_t value;
+        memcpy(&value, pData, sizeof(value));
+        return value;
+    }
+
+    case PLY_UINT32:
+    {
+        uint32_t value;
+        memcpy(&value, pData, sizeof(value));
+        return value;
+    }
+
+    case PLY_FLOAT32:
+    {
+        float value;
+        memcpy(&value, pData, sizeof(value));
+        return value;
+    }
+
+    case PLY_FLOAT64:
+    {
+        double value;
+        memcpy(&value, pData, sizeof(value));
+        return value;
+    }
+
+    default:
+        return 0.0;
+    }
+}
+
+//Read a scalar of the file, swapped first if the file is big endian
+double readFileValue(const char* pData, E_PlyType type, bool isSwapped)
+{
+    if(!isSwapped)
+    {
+        return readValue(pData, type);
+    }
+
+    char swapped[8];
+    size_t size = getTypeSize(type);
+    std::reverse_copy(pData, pData + size, swapped);
+    return readValue(swapped, type);
+}
+
+#ifdef PLY_SSSE3_SWAP
+//Swap the words of the first multiple of 16 bytes, return the number of bytes swapped
+PLY_SSSE3_TARGET size_t swapWordsSsse3(char* pData, size_t size, size_t wordSize)
+{
+    size_t idx = 0;
+    __m128i mask;
+
+    if(wordSize == 2)
+    {
+        mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    }
+    else if(wordSize == 4)
+    {
+        mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    }
+    else
+    {
+        mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+
+    //16 bytes hold a whole number of words of every size
+    for(; idx + 16 <= size; idx += 16)
+    {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData + idx));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pData + idx), _mm_shuffle_epi8(words, mask));
+    }
+
+    return idx;
+}
+#endif
+
+//Reverse the bytes of each word of wordSize bytes, size is a multiple of wordSize
+void swapWords(char* pData, size_t size, size_t wordSize)
+{
+    if(wordSize < 2)
+    {
+        return;
+    }
+
+    size_t idx = 0;
+
+#ifdef PLY_SSSE3_SWAP
+    static const bool hasSsse3 = PLY_HAS_SSSE3();
+
+    if(hasSsse3)
+    {
+        idx = swapWordsSsse3(pData, size, wordSize);
+    }
+#endif
+
+    for(; idx < size; idx += wordSize)
+    {
+        std::reverse(pData + idx, pData + idx + wordSize);
+    }
+}
+
+//Bring a block of fixed size records to the byte order of the host
+void swapRecords(char* pData, size_t recordCount, const PlyElement& element)
+{
+    //The common records only hold properties of one size, swapped as a single array of words
+    size_t wordSize = getTypeSize(element.properties[0].type);
+    bool isUniform = std::all_of(element.properties.begin(), element.properties.end(),
+                                 [wordSize](const PlyProperty & property)
+    {
+        return getTypeSize(property.type) == wordSize;
+    });
+
+    if(isUniform)
+    {
+        swapWords(pData, recordCount * element.recordSize, wordSize);
+        return;
+    }
+
+    for(size_t idxRecord = 0; idxRecord < recordCount; idxRecord++)
+    {
+        char* pRecord = pData + idxRecord * element.recordSize;
+
+        for(const PlyProperty& property : element.properties)
+        {
+            std::reverse(pRecord + property.offset, pRecord + property.offset + getTypeSize(property.type));
+        }
+    }
+}
+
+bool parseHeader(const MappedFile& file, std::vector<PlyElement>& elements, bool& isBigEndian, size_t& dataOffset)
+{
+    const char* pData = file.data();
+    const char* pEnd = pData + file.size();
+    const char* pLine = pData;
+    bool hasFormat = false;
+
+    while(pLine < pEnd)
+    {
+        const char* pLineEnd = static_cast<const char*>(memchr(pLine, '\n', pEnd - pLine));
+
+        if(pLineEnd == nullptr)
+        {
+            break;
+        }
+
+        std::istringstream line(std::string(pLine, pLineEnd));
+        pLine = pLineEnd + 1;
+        std::string keyword;
+        line >> keyword;
+
+        if(keyword == "ply" || keyword == "comment" || keyword == "obj_info" || keyword.empty())
+        {
+            continue;
+        }
+
+        if(keyword == "end_header")
+        {
+            dataOffset = pLine - pData;
+            return hasFormat;
+        }
+
+        if(keyword == "format")
+        {
+            std::string format;
+            line >> format;
+
+            if(format != "binary_little_endian" && format != "binary_big_endian")
+            {
+                PLOGE << "Unsupported ply format " << format << ", only the binary files are read" << '\n';
+                return false;
+            }
+
+            isBigEndian = format == "binary_big_endian";
+            hasFormat = true;
+        }
+        else if(keyword == "element")
+        {
+            elements.emplace_back();
+
+            if(!(line >> elements.back().name >> elements.back().count))
+            {
+                return false;
+            }
+        }
+        else if(keyword == "property" && !elements.empty())
+        {
+            PlyProperty property;
+            std::string type;
+            line >> type;
+
+            if(type == "list")
+            {
+                std::string countType;
+                line >> countType >> type;
+                property.countType = parseType(countType);
+
+                if(property.countType == PLY_INVALID || property.countType == PLY_FLOAT32
+                   || property.countType == PLY_FLOAT64)
+                {
+                    return false;
+                }
+            }
+
+            property.type = parseType(type);
+            line >> property.name;
+
+            if(property.type == PLY_INVALID || property.name.empty())
+            {
+                return false;
+            }
+
+            elements.back().properties.push_back(property);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+void computeRecordSizes(std::vector<PlyElement>& elements)
+{
+    for(PlyElement& element : elements)
+    {
+        size_t offset = 0;
+
+        for(PlyProperty& property : element.properties)
+        {
+            if(property.countType != PLY_INVALID)
+            {
+                offset = 0;
+                break;
+            }
+
+            property.offset = offset;
+            offset += getTypeSize(property.type);
+        }
+
+        element.recordSize = offset;
+    }
+}
+
+//Size of the element in the file, 0 if it overflows the end of the file
+size_t measureElement(const PlyElement& element, const char* pData, const char* pEnd, bool isSwapped)
+{
+    if(element.recordSize > 0)
+    {
+        size_t available = pEnd - pData;
+        return element.count <= available / element.recordSize ? element.count * element.recordSize : 0;
+    }
+
+    const char* p = pData;
+
+    for(size_t idxRecord = 0; idxRecord < element.count; idxRecord++)
+    {
+        for(const PlyProperty& property : element.properties)
+        {
+            size_t valueCount = 1;
+
+            if(property.countType != PLY_INVALID)
+            {
+                if(static_cast<size_t>(pEnd - p) < getTypeSize(property.countType))
+                {
+                    return 0;
+                }
+
+                valueCount = static_cast<size_t>(readFileValue(p, property.countType, isSwapped));
+                p += getTypeSize(property.countType);
+            }
+
+            if(static_cast<size_t>(pEnd - p) / getTypeSize(property.type) < valueCount)
+            {
+                return 0;
+            }
+
+            p += valueCount * getTypeSize(property.type);
+        }
+    }
+
+    return std::max<size_t>(p - pData, 1);
+}
+
+uint32_t findProperty(const PlyElement& element, std::initializer_list<const char*> names)
+{
+    for(const char* name : names)
+    {
+        for(size_t idx = 0; idx < element.properties.size(); idx++)
+        {
+            if(element.properties[idx].name == name)
+            {
+                return static_cast<uint32_t>(idx);
+            }
+        }
+    }
+
+    return NO_PROPERTY;
+}
+
+//Convert count records, already in the byte order of the host, to vertices
+void convertVertices(const char* pRecords, size_t count, const PlyElement& element, const VertexLayout& layout,
+                     data::VertexAttribute* pVertices)
+{
+    for(size_t idxVertex = 0; idxVertex < count; idxVertex++)
+    {
+        const char* pRecord = pRecords + idxVertex * element.recordSize;
+        float* pValues = &pVertices[idxVertex].pos.x;
+
+        for(size_t idx = 0; idx < 8; idx++)
+        {
+            uint32_t idxProperty = layout.properties[idx];
+
+            if(idxProperty != NO_PROPERTY)
+            {
+                const PlyProperty& property = element.properties[idxProperty];
+
+                //Most vertices only have floats, copied without the conversion through double
+                if(property.type == PLY_FLOAT32)
+                {
+                    memcpy(&pValues[idx], pRecord + property.offset, sizeof(float));
+                }
+                else
+                {
+                    pValues[idx] = static_cast<float>(readValue(pRecord + property.offset, property.type));
+                }
+            }
+        }
+    }
+}
+
+//Fans of the polygons of the face element, return false if an index is out of the vertices
+bool readFaces(const PlyElement& element, const char* pData, const MappedFile& file, bool isSwapped,
+               size_t vertexCount, std::vector<uint32_t>& indices, LoadProgress* pProgress)
+{
+    uint32_t idxIndices = findProperty(element, { "vertex_indices", "vertex_index" });
+
+    if(idxIndices == NO_PROPERTY || element.properties[idxIndices].countType == PLY_INVALID)
+    {
+        PLOGE << "The ply faces have no vertex_indices list" << '\n';
+        return false;
+    }
+
+    indices.reserve(element.count * 3);
+    std::vector<uint32_t> polygon;
+    const char* p = pData;
+    const char* pEnd = file.data() + file.size();
+    const char* pReleased = pData;
+
+    for(size_t idxFace = 0; idxFace < element.count; idxFace++)
+    {
+        for(size_t idxProperty = 0; idxProperty < element.properties.size(); idxProperty++)
+        {
+            const PlyProperty& property = element.properties[idxProperty];
+            size_t valueSize = getTypeSize(property.type);
+            size_t valueCount = 1;
+
+            if(property.countType != PLY_INVALID)
+            {
+                if(static_cast<size_t>(pEnd - p) < getTypeSize(property.countType))
+                {
+                    PLOGE << "The ply faces overflow the file" << '\n';
+                    return false;
+                }
+
+                valueCount = static_cast<size_t>(readFileValue(p, property.countType, isSwapped));
+                p += getTypeSize(property.countType);
+            }
+
+            if(static_cast<size_t>(pEnd - p) / valueSize < valueCount)
+            {
+                PLOGE << "The ply faces overflow the file" << '\n';
+                return false;
+            }
+
+            if(idxProperty == idxIndices)
+            {
+                polygon.resize(valueCount);
+
+                for(size_t idx = 0; idx < valueCount; idx++)
+                {
+                    double index = readFileValue(p + idx * valueSize, property.type, isSwapped);
+
+                    if(index < 0.0 || index >= vertexCount)
+                    {
+                        PLOGE << "Ply face " << idxFace << " uses a vertex out of the file" << '\n';
+                        return false;
+                    }
+
+                    polygon[idx] = static_cast<uint32_t>(index);
+                }
+
+                for(size_t idx = 2; idx < valueCount; idx++)
+                {
+                    indices.push_back(polygon[0]);
+                    indices.push_back(polygon[idx - 1]);
+                    indices.push_back(polygon[idx]);
+                }
+            }
+
+            p += valueCount * valueSize;
+        }
+
+        if((idxFace + 1) % FACE_BLOCK_SIZE == 0)
+        {
+            file.release(pReleased - file.data(), p - pReleased);
+
+            if(pProgress)
+            {
+                pProgress->parsedBytes += p - pReleased;
+
+                if(pProgress->cancelled)
+                {
+                    return false;
+                }
+            }
+
+            pReleased = p;
+        }
+    }
+
+    file.release(pReleased - file.data(), p - pReleased);
+
+    if(pProgress)
+    {
+        pProgress->parsedBytes += p - pReleased;
+    }
+
+    return true;
+}
+
+}
+
+PlyLoader::PlyLoader() :
+    Loader()
+{
+
+}
+
+PlyLoader::~PlyLoader()
+{
+
+}
+
+bool PlyLoader::loadStreaming(const std::string& path, const MeshCallback& onMesh)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    MappedFile file;
+
+    if(!file.open(path))
+    {
+        return false;
+    }
+
+    if(pProgress_)
+    {
+        pProgress_->totalBytes = file.size();
+    }
+
+    std::vector<PlyElement> elements;
+    bool isBigEndian = false;
+    size_t dataOffset = 0;
+
+    if(file.size() < 4 || memcmp(file.data(), "ply", 3) != 0
+       || !parseHeader(file, elements, isBigEndian, dataOffset))
+    {
+        PLOGE << path << " is not a valid binary ply file" << '\n';
+        return false;
+    }
+
+    computeRecordSizes(elements);
+
+    //Host assumed little endian, like every platform the renderer runs on
+    bool isSwapped = isBigEndian;
+    std::string name = path.substr(path.find_last_of("/\\") + 1);
+    name = name.substr(0, name.find_last_of('.'));
+
+    //Offset of each element in the file, the elements after the faces are ignored
+    const PlyElement* pVertexElement = nullptr;
+    const PlyElement* pFaceElement = nullptr;
+    size_t vertexOffset = 0;
+    size_t faceOffset = 0;
+    size_t offset = dataOffset;
+
+    for(const PlyElement& element : elements)
+    {
+        if(element.name == "vertex" && pVertexElement == nullptr)
+        {
+            pVertexElement = &element;
+            vertexOffset = offset;
+        }
+        else if(element.name == "face" && pFaceElement == nullptr)
+        {
+            pFaceElement = &element;
+            faceOffset = offset;
+            break;
+        }
+
+        size_t size = measureElement(element, file.data() + offset, file.data() + file.size(), isSwapped);
+
+        if(size == 0 && element.count > 0)
+        {
+            PLOGE << path << " : the element " << element.name << " overflows the file" << '\n';
+            return false;
+        }
+
+        offset += size;
+    }
+
+    if(pVertexElement == nullptr || pVertexElement->recordSize == 0)
+    {
+        PLOGE << path << " has no vertex element or its vertices have lists" << '\n';
+        return false;
+    }
+
+    VertexLayout layout =
+    {
+        {
+            findProperty(*pVertexElement, { "x" }), findProperty(*pVertexElement, { "y" }),
+            findProperty(*pVertexElement, { "z" }), findProperty(*pVertexElement, { "nx" }),
+            findProperty(*pVertexElement, { "ny" }), findProperty(*pVertexElement, { "nz" }),
+            findProperty(*pVertexElement, { "u", "s", "texture_u" }), findProperty(*pVertexElement, { "v", "t", "texture_v" })
+        }
+    };
+
+    if(layout.properties[0] == NO_PROPERTY || layout.properties[1] == NO_PROPERTY || layout.properties[2] == NO_PROPERTY)
+    {
+        PLOGE << path << " : the vertices have no position" << '\n';
+        return false;
+    }
+
+    const PlyElement& vertexElement = *pVertexElement;
+    bool isPointCloud = pFaceElement == nullptr || pFaceElement->count == 0;
+
+    if(!isPointCloud && vertexElement.count > 0xFFFFFFFFu)
+    {
+        PLOGE << path << " has too many vertices for 32 bits indices" << '\n';
+        return false;
+    }
+
+    resetOptimizationTotals();
+
+    ThreadPool pool;
+    size_t blockCount = (vertexElement.count + PLY_BLOCK_SIZE - 1) / PLY_BLOCK_SIZE;
+    std::atomic<bool> isValid(true);
+    data::Mesh mesh;
+    mesh.name = name;
+
+    if(!isPointCloud)
+    {
+        mesh.vertices.resize(vertexElement.count);
+    }
+
+    //Point clouds : each block is a mesh, given in the order of the file once all the previous ones are
+    std::vector<data::Mesh> blockMeshes(isPointCloud ? blockCount : 0);
+    std::mutex emitMutex;
+    std::vector<uint8_t> isBuilt(blockMeshes.size(), 0);
+    size_t nextMesh = 0;
+
+    pool.parallelFor(blockCount, [&](size_t idxBlock)
+    {
+        if(!isValid || isCancelled())
+        {
+            isValid = false;
+            return;
+        }
+
+        size_t first = idxBlock * PLY_BLOCK_SIZE;
+        size_t count = std::min(PLY_BLOCK_SIZE, vertexElement.count - first);
+        size_t blockOffset = vertexOffset + first * vertexElement.recordSize;
+        size_t blockSize = count * vertexElement.recordSize;
+        const char* pRecords = file.data() + blockOffset;
+        //Only a block is swapped at a time, the file is never copied whole
+        std::vector<char> swappedRecords;
+
+        if(isSwapped)
+        {
+            swappedRecords.assign(pRecords, pRecords + blockSize);
+            swapRecords(swappedRecords.data(), count, vertexElement);
+            pRecords = swappedRecords.data();
+        }
+
+        data::VertexAttribute* pVertices;
+
+        if(isPointCloud)
+        {
+            data::Mesh& blockMesh = blockMeshes[idxBlock];
+            blockMesh.name = blockCount > 1 ? name + "_" + std::to_string(idxBlock) : name;
+            blockMesh.vertices.resize(count);
+            pVertices = blockMesh.vertices.data();
+        }
+        else
+        {
+            pVertices = mesh.vertices.data() + first;
+        }
+
+        convertVertices(pRecords, count, vertexElement, layout, pVertices);
+        file.release(blockOffset, blockSize);
+
+        if(pProgress_)
+        {
+            pProgress_->parsedBytes += blockSize;
+        }
+
+        if(!isPointCloud)
+        {
+            return;
+        }
+
+        processMesh(blockMeshes[idxBlock], &pool);
+
+        std::lock_guard<std::mutex> lock(emitMutex);
+        isBuilt[idxBlock] = 1;
+
+        while(isValid && nextMesh < blockMeshes.size() && isBuilt[nextMesh])
+        {
+            if(pProgress_)
+            {
+                pProgress_->meshCount++;
+            }
+
+            onMesh(std::make_shared<const data::Mesh>(std::move(blockMeshes[nextMesh])));
+            blockMeshes[nextMesh++] = data::Mesh();
+        }
+    });
+
+    if(!isValid)
+    {
+        return false;
+    }
+
+    auto vertexTime = std::chrono::high_resolution_clock::now();
+
+    if(!isPointCloud)
+    {
+        if(!readFaces(*pFaceElement, file.data() + faceOffset, file, isSwapped, vertexElement.count, mesh.indices,
+                      pProgress_))
+        {
+            return false;
+        }
+
+        processMesh(mesh, &pool);
+
+        if(pProgress_)
+        {
+            pProgress_->meshCount++;
+        }
+
+        onMesh(std::make_shared<const data::Mesh>(std::move(mesh)));
+    }
+
+    if(pProgress_)
+    {
+        pProgress_->parsedBytes = file.size();
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    PLOGI << path << " loaded in "
+          << std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count()
+          << " ms : " << vertexElement.count << " vertices in "
+          << std::chrono::duration<float, std::chrono::milliseconds::period>(vertexTime - startTime).count()
+          << " ms with " << pool.size() << " threads" << (isSwapped ? " (byte swapped)" : "")
+          << (isPointCloud ? ", point cloud" : "") << '\n';
+
+    logOptimizationTotals(path);
+    return true;
+}
@@ -0,0 +1,132 @@
+#include "loader/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    if(threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(threadCount);
+
+    for(size_t idx = 0; idx < threadCount; idx++)
+    {
+        workers_.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+
+    condition_.notify_all();
+
+    for(std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::work()
+{
+    while(true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]()
+            {
+                return stopping_ || !tasks_.empty();
+            });
+
+            if(tasks_.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+
+        task();
+    }
+}
+
+size_t ThreadPool::size() const
+{
+    return workers_.size();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+    //Shared with the helper tasks, which may only start once the loop is over
+    struct LoopState
+    {
+        std::atomic<size_t> nextIdx{0};
+        std::mutex mutex;
+        std::condition_variable doneCondition;
+        size_t doneCount = 0;
+        std::exception_ptr error;
+    };
+
+    std::shared_ptr<LoopState> state = std::make_shared<LoopState>();
+    const std::function<void(size_t)>* pFunction = &function;
+
+    //Each thread pulls the next index, so uneven workloads are balanced between the workers. The function
+    //is only read for an index claimed before the end of the loop, while the caller still waits
+    auto runLoop = [state, pFunction, count]()
+    {
+        for(size_t idx = state->nextIdx++; idx < count; idx = state->nextIdx++)
+        {
+            std::exception_ptr error;
+
+            try
+            {
+                (*pFunction)(idx);
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            if(error)
+            {
+                state->error = error;
+            }
+
+            if(++state->doneCount == count)
+            {
+                state->doneCondition.notify_all();
+            }
+        }
+    };
+
+    size_t helperCount = std::min(count, workers_.size()) - (count > 0 ? 1 : 0);
+
+    for(size_t idxTask = 0; idxTask < helperCount; idxTask++)
+    {
+        enqueue(runLoop);
+    }
+
+    //The caller works too : called from a task of the pool, it progresses even if no helper starts
+    runLoop();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->doneCondition.wait(lock, [&state, count]()
+    {
+        return state->doneCount == count;
+    });
+
+    if(state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
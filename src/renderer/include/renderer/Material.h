@@ -2,24 +2,35 @@
 
 #include "renderer/VkElement.h"
 #include "renderer/texture/MaterialTexture.h"
+#include <glm/vec3.hpp>
+#include <memory>
+#include <string>
 
 namespace renderer
 {
 
-class Material : VkElement
+/*@brief : Diffuse color and texture of the meshes using the material. The texture is bound through a
+*          descriptor set of the material, allocated from the material pool of the core
+*/
+class Material : public VkElement
 {
 protected:
-    MaterialTexture albedo;
+    std::string name_;
+    glm::vec3 diffuseColor_;
+    //Shared with the other materials using the same image
+    std::shared_ptr<MaterialTexture> pAlbedo_;
+    VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;
 
 public:
-    Material(const VulkanCore* pCore);
+    Material(const VulkanCore* pCore, const std::string& name, const glm::vec3& diffuseColor,
+             const std::shared_ptr<MaterialTexture>& pAlbedo);
 
     virtual void create() override;
     virtual void destroy() override;
 
-    void setAlbedo(const MaterialTexture& texture);
-
-    void getDescriptorSet();
+    const std::string& getName() const;
+    const glm::vec3& getDiffuseColor() const;
+    const VkDescriptorSet& getDescriptorSet() const;
 
     virtual ~Material() override;
 
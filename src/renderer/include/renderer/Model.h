@@ -3,38 +3,129 @@
 #include "data/3D/Mesh.h"
 #include "renderer/VkElement.h"
 #include "renderer/Material.h"
+#include "renderer/UploadBatch.h"
+#include "renderer/Vertex.h"
+#include "renderer/memory/MemoryAllocator.h"
+#include <glm/vec3.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
 
 namespace renderer
 {
 
-struct MeshData
+enum E_MeshResidency
+{
+    KEEP_HOST_MESHES, //The meshes stay in host memory as long as the model
+    RELEASE_HOST_MESHES //Only on the device once uploaded, loaded again when the CPU needs them
+};
+
+// What the model knows of a mesh whose vertices and indices were released from the host memory
+struct MeshInfo
 {
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
-    VkBuffer vertexIndexBuffer;
-    VkDeviceMemory vertexIndexBufferMemory;
-    bool isAllocated = false;
+    std::string name;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    //Sphere around the center of the bounding box, enough to estimate the distance to the camera
+    glm::vec3 boundsCenter;
+    float boundsRadius = 0.0f;
+    data::MaterialData material;
+};
 
-    Material const* material;
+// Range of the index buffer of a mesh drawing one of its levels of detail
+struct LodRange
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;
+};
+
+// Vertices and indices of the meshes uploaded together, drawn with the same bindings
+struct MeshBuffers
+{
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    MemoryAllocation vertexBufferMemory;
+    //The 16 bits indices followed by the 32 bits ones, VK_NULL_HANDLE if every mesh is a point cloud
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    MemoryAllocation indexBufferMemory;
+};
+
+struct MeshData
+{
+    //The buffers of the model holding the mesh
+    uint32_t buffersIndex = 0;
+    //First vertex of the mesh in the vertex buffer, added to its indices
+    uint32_t vertexOffset = 0;
+    //Start of the indices of the type of the mesh in the index buffer, the ranges of lods count from there
+    VkDeviceSize indexBufferOffset = 0;
+    //VK_INDEX_TYPE_UINT16 when the mesh has few enough vertices
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    //Set once the copies are complete and the graphics queue acquired the buffers, drawn from then on
+    bool isUploaded = false;
+    //A mesh without indices is drawn as points, it has no index buffer
+    bool isPointCloud = false;
+    uint32_t vertexCount = 0;
+
+    //lods[0] is the full mesh, followed in the index buffer by each level of detail
+    std::vector<LodRange> lods;
+    uint32_t selectedLod = 0;
+    //Used by the compact vertex shader to restore the positions
+    data::QuantizationBounds quantizationBounds;
+
+    //Owned by the core, nullptr draws the mesh with the default material
+    Material const* material = nullptr;
 };
 
 class Model : public VkElement
 {
+public:
+    // Largest vertex or index buffer shared by several meshes, staged without growing StagingRing::INITIAL_SIZE
+    static constexpr VkDeviceSize MAX_PACKED_SIZE = 8 * 1024 * 1024;
+
+    // Load the meshes of the model again, in the same order as the first time
+    using MeshSource = std::function<bool(std::vector<data::MeshPtr>& meshes)>;
 
 protected:
+    // Meshes copied by a submission of the transfer queue, not drawn yet
+    struct PendingUpload
+    {
+        uint64_t batchId;
+        size_t firstMesh;
+        size_t meshCount;
+        size_t firstBuffers;
+        size_t buffersCount;
+    };
+
     using VkElement::pCore_;
 
     std::string name_;
-
-    std::vector<data::Mesh> meshes_;
+    E_VertexFormat vertexFormat_ = STANDARD_VERTEX;
+    E_MeshResidency residency_ = KEEP_HOST_MESHES;
+    MeshSource meshSource_;
+
+    std::vector<MeshInfo> meshInfos_;
+    //Shared with the loader and its cache, never copied. Empty once the meshes are released
+    std::vector<data::MeshPtr> meshes_;
+    //Still valid while a CPU consumer holds the released meshes, they are not loaded twice meanwhile
+    mutable std::vector<std::weak_ptr<const data::Mesh>> hostMeshes_;
     std::vector<MeshData> meshesData_;
+    std::vector<MeshBuffers> meshBuffers_;
+    //In the order of submission, the batches complete in this order
+    std::deque<PendingUpload> pendingUploads_;
     //static Material const* defaultMaterial;
 
-    //Allocate the memory on device for the specified mesh in the meshdata
-    void createMeshData(const data::Mesh& mesh, MeshData& meshData);
-    void createVertexBuffer(const data::Mesh& mesh, MeshData& meshData);
-    void createVertexIndexBuffer(const data::Mesh& mesh, MeshData& meshData);
-    void destroyMeshData(MeshData& meshData);
+    // The host meshes still held by a CPU consumer, stops at the first released one
+    std::vector<data::MeshPtr> lockHostMeshes() const;
+
+    // Submit the copies of the meshes from firstMesh and of their buffers without waiting for them
+    void submitUpload(UploadBatch& batch, size_t firstMesh, size_t firstBuffers);
+
+    // Pack the meshes in as few buffers as MAX_PACKED_SIZE allows, the mesh data from firstMesh is filled.
+    // The copies are recorded in the batch, the buffers can be used once it is submitted and acquired
+    void createMeshBuffers(const std::vector<data::MeshPtr>& meshes, size_t firstMesh, UploadBatch& batch);
+    void createPackedBuffers(const std::vector<data::MeshPtr>& meshes, size_t idxBegin, size_t idxEnd,
+                             size_t firstMesh, UploadBatch& batch);
+    void destroyMeshBuffers();
 
 
     void setMaterialForMeshData(MeshData& meshData,
@@ -42,20 +133,58 @@ protected:
 
 public:
     Model(const VulkanCore* pCore);
+    //The buffers of the meshes belong to a single model
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
 
     virtual void create() override;
     virtual void destroy() override;
 
-    void assignMesh(const std::vector<data::Mesh>& meshes);
-    void clearMesh();
-
-    void setMaterialForMesh(const data::Mesh& mesh, const Material& material);
+    void assignMesh(const std::vector<data::MeshPtr>& meshes);
+    // Add a mesh to the model, its buffers are created right away if the model already is
+    void appendMesh(const data::MeshPtr& mesh);
+    // Same as appendMesh, the buffers of the meshes are uploaded by a single submission
+    void appendMeshes(const std::vector<data::MeshPtr>& meshes);
+    // The meshes are uploaded by the transfer queue while the previous ones are drawn. Poll the uploads once
+    // per frame, before recording the draws : the graphics queue acquires the buffers copied since the last
+    // call. Return true if meshes can be drawn from now on
+    bool updateUploads();
+
+    // RELEASE_HOST_MESHES drops the host meshes now, and after each upload from then on. Set it once
+    // every mesh is added : the meshes released are loaded again from the source of the model
+    void setResidency(E_MeshResidency residency);
+    E_MeshResidency getResidency() const;
+    void setMeshSource(const MeshSource& meshSource);
+    const MeshSource& getMeshSource() const;
+    // The meshes in host memory for the CPU consumers (picking, export...), loaded again if they were
+    // released. They stay in memory as long as the returned pointers. Empty if the load fails
+    std::vector<data::MeshPtr> getHostMeshes() const;
+    // True if no mesh is released, create uploads them without loading them again
+    bool hasHostMeshes() const;
+    // Meshes given by the source on another thread, create uploads them while the caller holds them.
+    // False if they don't match the meshes of the model anymore
+    bool restoreHostMeshes(const std::vector<data::MeshPtr>& meshes) const;
+
+    // Select for each mesh the coarsest level of detail whose error, once projected, is below
+    // maxPixelError pixels. pixelsPerUnit is the size in pixels of a unit seen at a distance of 1.
+    // Return true if the selection changed
+    bool selectLods(const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError);
+
+    // The buffers of the mesh must be created, the material must outlive the model
+    void setMaterialForMesh(size_t idxMesh, const Material& material);
     //static void setDefaultMaterial(const Material& material);
 
+    E_VertexFormat getVertexFormat() const;
+    // The buffers are created again in the new format if the model already is
+    void setVertexFormat(E_VertexFormat format);
+
     const std::string& getName() const;
     void setName(const std::string& name);
+    // One per mesh created, empty while the model is not created. Only draw the uploaded ones
     const std::vector<MeshData>& getMeshData()const;
-    const std::vector<data::Mesh>& getMeshes()const;
+    const std::vector<MeshBuffers>& getMeshBuffers()const;
+    // One per mesh, whether it is in host memory or not
+    const std::vector<MeshInfo>& getMeshInfos()const;
 
     virtual ~Model() override;
 };
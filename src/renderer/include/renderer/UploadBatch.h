@@ -0,0 +1,67 @@
+#pragma once
+
+#include "renderer/VkElement.h"
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+/*@brief : Records the copies from the staging ring and the layout transitions of several resources in
+*          a command buffer, submitted once with a single fence. The batch is split in several submissions
+*          when its staged data would take more than half of the ring, so that the ring can be reused
+*          while the rest is recorded. On a distinct transfer queue family, the buffers copied are released
+*          to the graphics family at the end of each submission : they must be acquired by a batch on the
+*          graphics queue once the submission is complete. Only from the thread owning the vulkan core
+*/
+class UploadBatch
+{
+private:
+    const VulkanCore* pCore_;
+    //The transfer queue for the buffers, the graphics one for the images and their mipmaps
+    bool useTransfer_;
+    //The buffers copied change of queue family
+    bool releasesBuffers_;
+
+    VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+    //Buffers copied since the last submission, given to the graphics family with it
+    std::vector<VkBufferMemoryBarrier> releaseBarriers_;
+    //0 once the submissions are waited for or handed to the caller
+    uint64_t lastBatchId_ = 0;
+    VkDeviceSize stagedSize_ = 0;
+    uint32_t commandCount_ = 0;
+
+    VkCommandBuffer beginCommandBuffer();
+    // Submit the commands recorded so far without waiting for them
+    void flush();
+    // Room in the staging ring for size bytes
+    void* stage(VkDeviceSize size, VkBuffer& stagingBuffer, VkDeviceSize& stagingOffset);
+
+public:
+    UploadBatch(const VulkanCore* pCore, bool useTransfer);
+    UploadBatch(const UploadBatch&) = delete;
+    UploadBatch& operator=(const UploadBatch&) = delete;
+    // Submit and wait for the commands not submitted yet
+    ~UploadBatch();
+
+    // Record a copy to dstBuffer, the returned size bytes must be written before the next call
+    void* stageBufferCopy(VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+    void copyToBuffer(const void* pData, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+    // Copy 4 bytes per pixel to the first mip level of the image, in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    void copyToImage(const void* pPixels, VkImage image, uint32_t width, uint32_t height);
+    void pipelineBarrier(VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+                         const VkImageMemoryBarrier& barrier);
+    // On the graphics queue, make the copies to a buffer by a complete transfer batch visible to dstStage,
+    // acquiring the buffer from the transfer family if it was released
+    void acquireBuffer(VkBuffer buffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+    // To record other commands, valid until the next call of the batch
+    VkCommandBuffer getCommandBuffer();
+
+    // Submit the commands and wait for them, the resources can be used once it returns
+    void submit();
+    // Submit the commands without waiting. Return the id of the last batch of the staging ring used, to
+    // poll it with StagingRing::isBatchComplete, 0 if nothing was recorded
+    uint64_t submitAsync();
+};
+
+}
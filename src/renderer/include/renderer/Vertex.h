@@ -1,6 +1,7 @@
 #pragma once
 
 #include <data/3D/VertexAttribute.h>
+#include <data/3D/VertexQuantizer.h>
 #include <vulkan/vulkan.h>
 #include <array>
 
@@ -8,10 +9,23 @@
 namespace renderer
 {
 
+enum E_VertexFormat
+{
+    STANDARD_VERTEX, //Vertex, 32 bytes of floats
+    COMPACT_VERTEX //CompactVertex, 16 bytes
+};
+
 struct Vertex : public data::VertexAttribute
 {
     static VkVertexInputBindingDescription getBindingDescription();
     static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions();
 };
 
+// Dequantized by the compact vertex shader with the QuantizationBounds pushed for each mesh
+struct CompactVertex : public data::CompactVertexAttribute
+{
+    static VkVertexInputBindingDescription getBindingDescription();
+    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions();
+};
+
 }
@@ -9,15 +9,20 @@
 
 #include <plog/Log.h>
 #include <vulkan/vulkan.h>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include "renderer/DebugMessenger.h"
 #include "renderer/PhysicalDeviceProvider.h"
 #include "renderer/Swapchain.h"
 #include "renderer/VulkanUtils.h"
+#include "renderer/memory/StagingRing.h"
 #include "renderer/Vertex.h"
 #include "renderer/texture/MaterialTexture.h"
+#include "renderer/texture/TextureCache.h"
 #include "renderer/camera/Camera.h"
 #include "renderer/Model.h"
 
@@ -40,12 +45,36 @@ protected :
         bool modelModified = false;
     };
 
-    struct UniformBufferObject
+    //Shared by the objects of the frame, the vectors are vec4 to match the std140 layout
+    struct CameraData
     {
-        glm::mat4x4 model;
         glm::mat4x4 view;
         glm::mat4x4 projection;
-        glm::vec3 lightPos;
+        glm::mat4x4 inverseView;
+        glm::vec4 eyePosition;
+        glm::vec4 lightPosition;
+    };
+
+    //Computed once per object and per frame, read by the vertex shaders with the instance index
+    struct ObjectData
+    {
+        glm::mat4x4 model;
+        //mat3 of the inverse transpose of the model, stored as a mat4 for the std430 layout
+        glm::mat4x4 normal;
+        glm::mat4x4 mvp;
+    };
+
+    //Pushed for each mesh drawn with the compact vertices, pos = offset + quantized pos * scale
+    struct QuantizationConstants
+    {
+        glm::vec4 offset;
+        glm::vec4 scale;
+    };
+
+    //Pushed for each mesh to the fragment shader, after the quantization constants
+    struct MaterialConstants
+    {
+        glm::vec4 diffuseColor;
     };
 
     const std::vector<const char*> DEVICE_EXTENSIONS =
@@ -54,6 +83,15 @@ protected :
     };
 
     const int MAX_FRAMES_IN_FLIGHT = 2;
+    //Largest error on screen, in pixels, accepted when a coarser level of detail is selected
+    const float LOD_PIXEL_ERROR = 1.0f;
+    //Descriptor sets of the material pool, the meshes of the next materials use the default one
+    const uint32_t MAX_MATERIAL_COUNT = 1024;
+    //Entries of the object data of a frame, one per model displayed, drawn with the index of their entry as
+    //first instance
+    const uint32_t MAX_OBJECT_COUNT = 1;
+    //Entry of the model displayed
+    const uint32_t MODEL_OBJECT_INDEX = 0;
     VkInstance instance_;
     std::vector<const char*> requiredExtensions_;
     VkPhysicalDeviceFeatures requiredDeviceFeatures_;
@@ -64,6 +102,8 @@ protected :
 
     DebugMessenger debugMessenger_;
     VulkanUtils utilities_;
+    //Every upload goes through it, created with the command pools
+    std::unique_ptr<StagingRing> pStagingRing_;
 
     VkSurfaceKHR surface_;
 
@@ -77,34 +117,49 @@ protected :
     VkRenderPass renderPass_;
     VkDescriptorSetLayout descriptorSetLayout_;
     VkDescriptorPool descriptorPool_;
-    std::vector<VkDescriptorSet> descriptorSets_;
+    //Bound with the dynamic offset of the uniform slot of each swapchain image
+    VkDescriptorSet descriptorSet_;
+    //Set 1 of the pipeline layout, the texture of the material
+    VkDescriptorSetLayout materialSetLayout_;
+    VkDescriptorPool materialDescriptorPool_;
     VkPipelineLayout pipelineLayout_;
     VkPipeline graphicsPipeline_;
+    //Same states with the vertex input and shader of the compact vertices
+    VkPipeline compactPipeline_;
+    //Point lists without culling, for the meshes without indices
+    VkPipeline pointPipeline_;
+    VkPipeline compactPointPipeline_;
     VkViewport viewport_;
 
     VkCommandPool commandPool_;
     VkCommandPool commandPoolTransfert_;
     std::vector<VkCommandBuffer> commandBuffers_;
+    //Recorded again by drawFrame before the next submission of their image
+    std::vector<bool> outdatedCommandBuffers_;
 
     //used to synchronise the image to show
     std::vector<VkSemaphore> imageAvailableSemaphore_; //An image is ready to render
     std::vector<VkSemaphore> renderFinishedSemaphore_; //An image is rendered and wait to be presented
     std::vector<VkFence> inFlightFences_;
+    //Fence of the last frame rendered to each swapchain image, VK_NULL_HANDLE before the first one
+    std::vector<VkFence> imagesInFlight_;
     size_t currentFrame_ = 0;
 
-    VkBuffer vertexBuffer_;
-    VkDeviceMemory vertexBufferMemory_;
-    VkBuffer vertexIndexBuffer_;
-    VkDeviceMemory vertexIndexBufferMemory_;
-    std::vector<VkBuffer> uniformBuffers_;
-    std::vector<VkDeviceMemory> uniformBuffersMemory_;
+    //A slot per swapchain image, only the slot of the image rendered is written. A slot holds the camera
+    //data followed by the object data
+    VkBuffer uniformBuffer_;
+    //Mapped by the allocator for the whole life of the buffer
+    MemoryAllocation uniformBufferMemory_;
+    //Aligned on the offset alignments of the uniform and storage buffers
+    VkDeviceSize uniformSlotSize_ = 0;
+    VkDeviceSize objectDataOffset_ = 0;
 
     VkImage depthImage_;
     VkImageView depthImageView_;
-    VkDeviceMemory depthImageMemory_;
+    MemoryAllocation depthImageMemory_;
 
     VkImage colorImage_;
-    VkDeviceMemory colorMemory_;
+    MemoryAllocation colorMemory_;
     VkImageView colorImageView_;
 
     VkSampleCountFlagBits msaaSamples_ = VK_SAMPLE_COUNT_1_BIT;
@@ -118,10 +173,14 @@ protected :
 
     /******************************************* APPLICATION VARIABLE ******************************************************/
 
-    MaterialTexture lenaTexture_;
+    TextureCache textureCache_;
+    //Materials of the meshes uploaded so far, by content, shared by the models
+    std::unordered_map<std::string, std::unique_ptr<Material>> materials_;
+    //Meshes without material in their file, textured with default.bmp
+    std::unique_ptr<Material> pDefaultMaterial_;
     Camera camera_;
-    std::vector<data::Mesh> meshes_;
-    Model model_;
+    //Owned by the application, nullptr when no model is displayed
+    Model* pModel_ = nullptr;
     ApplicationStateChange applicationChanges_;
 
     /***********************************************************************************************************************/
@@ -140,10 +199,13 @@ protected :
     void createGraphicsPipeline();
     void createCommandPool();
     void createCommandBuffers();
+    // Record the draws of the model for the swapchain image, its command buffer must not be pending
+    void recordCommandBuffer(size_t imageIndex);
     void createDepthRessources();
     void createColorRessources();
 
-    void recreateCommandBuffer();
+    // The command buffers are recorded again one at a time, when their image is acquired
+    void outdateCommandBuffers();
 
     //Shader Loading and Creation
 
@@ -152,8 +214,6 @@ protected :
 
     // Buffer Management
 
-    void createVertexBuffer();
-    void createVertexIndexBuffer();
     void createUniformBuffer();
     void updateUniformBuffer(uint32_t imageIndex);
 
@@ -162,9 +222,14 @@ protected :
     void createDescriptorSetLayout();
     void createDescriptorPool();
     void createDescriptorSets();
+    void createDefaultMaterial();
+    // Material created on the first use, the default one if the material pool is full
+    const Material& findMaterial(const data::MaterialData& materialData);
 
     // Synchronisation
     void createSyncObjects();
+    void updateModelUploads();
+    void selectModelLods();
     void checkApplicationState();
 
     void cleanup();
@@ -185,6 +250,12 @@ public:
     const VkCommandPool& getCommandPool()const;
 
     const VulkanUtils& getUtils()const;
+    // Only from the thread owning the vulkan core
+    StagingRing& getStagingRing()const;
+    const VkDescriptorSetLayout& getMaterialSetLayout()const;
+    const VkDescriptorPool& getMaterialDescriptorPool()const;
+    // The images can be prefetched from any thread, see TextureCache
+    TextureCache& getTextureCache();
 
     /******************************************* APPLICATION FUNCTIONS ******************************************************/
 
@@ -198,7 +269,12 @@ public:
     void resizeExtent(int width, int height);
 
     void setCamera(const Camera& camera);
-    void setModel(const Model& model);
+    // Upload the meshes of the model and draw it instead of the current one, whose buffers are released.
+    // The meshes are drawn as their uploads complete. The model must outlive its display, nullptr displays nothing
+    void setModel(Model* pModel);
+    // Add meshes streamed after the model was set and upload them together, they are drawn from the first frame
+    // after the transfer queue copied them
+    void appendMeshesToModel(const std::vector<data::MeshPtr>& meshes);
 
     void drawFrame();
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "VkElement.h"
+#include "renderer/memory/MemoryAllocator.h"
+#include <memory>
 
 namespace renderer
 {
@@ -9,25 +11,43 @@ class VulkanUtils
 {
 private:
     const VulkanCore* pCore_;
+    //Every buffer and image memory comes from it
+    std::unique_ptr<MemoryAllocator> pAllocator_;
+
 public:
     VulkanUtils(const VulkanCore* pCore);
     ~VulkanUtils();
 
+    // After the creation of the logical device, destroyed once every resource is
+    void createAllocator();
+    void destroyAllocator();
+    MemoryAllocator& getAllocator()const;
+
     VkImageView createImageView(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags,
                                 uint32_t mipLevels, VkImageViewCreateFlags flags = 0)const;
+    // The memory of a host visible buffer is mapped at bufferMemory.pMapped. An exclusive buffer used by the
+    // transfer and the graphics queues must be released and acquired, see UploadBatch
     void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-                      VkBuffer& buffer, VkDeviceMemory& bufferMemory)const;
+                      VkBuffer& buffer, MemoryAllocation& bufferMemory,
+                      VkSharingMode sharingMode = VK_SHARING_MODE_CONCURRENT)const;
+    // Destroy the buffer and free its memory, nothing is done for a null buffer
+    void destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory)const;
     VkCommandBuffer beginSingleTimeCommands(bool useTransfer) const;
-    void endSingleTimeCommands(VkCommandBuffer commandBuffer, bool useTransfer)const;
-    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)const;
+    // The fence, if any, is signaled by the submission
+    void endSingleTimeCommands(VkCommandBuffer commandBuffer, bool useTransfer,
+                               VkFence fence = VK_NULL_HANDLE)const;
+    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0,
+                    VkFence fence = VK_NULL_HANDLE)const;
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)const;
     void createImage(uint32_t width, uint32_t height, uint32_t mipLevels,
                      VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
                      VkMemoryPropertyFlags property,
-                     VkImage& image, VkDeviceMemory& imageMemory, VkImageCreateFlags flags = 0)const;
+                     VkImage& image, MemoryAllocation& imageMemory, VkImageCreateFlags flags = 0)const;
+    void destroyImage(VkImage image, MemoryAllocation& imageMemory)const;
     void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout,
                                VkImageLayout newLayout, uint32_t mipLevels)const;
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)const;
+    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height,
+                           VkDeviceSize bufferOffset = 0, VkFence fence = VK_NULL_HANDLE)const;
     bool hasStencilComponent(VkFormat format) const;
     VkSampleCountFlagBits getMaxUsableSampleCount();
 };
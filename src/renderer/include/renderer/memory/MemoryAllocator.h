@@ -0,0 +1,111 @@
+#pragma once
+
+#include "renderer/VkElement.h"
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace renderer
+{
+
+// Power of two sized VkDeviceMemory split in nodes by a buddy allocator
+struct MemoryBlock
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    uint32_t memoryType = 0;
+    //Only holds optimal images when they can't share a page with the linear resources
+    bool isOptimalImage = false;
+    //The block is a single node of this order
+    uint32_t maxOrder = 0;
+    //Whole block mapped once, nullptr unless its memory is host visible
+    char* pMapped = nullptr;
+    //Offsets of the free nodes of each order
+    std::vector<std::set<VkDeviceSize>> freeNodes;
+    uint32_t allocationCount = 0;
+};
+
+// Part of a VkDeviceMemory given by the MemoryAllocator, the resource is bound at offset
+struct MemoryAllocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    //Size requested by the resource
+    VkDeviceSize size = 0;
+    //Start of the allocation in host memory, nullptr unless its memory is host visible
+    void* pMapped = nullptr;
+    //nullptr for a dedicated allocation, which owns its memory
+    MemoryBlock* pBlock = nullptr;
+    uint32_t memoryType = 0;
+    //The node reserved in the block is MIN_NODE_SIZE << order bytes
+    uint32_t order = 0;
+};
+
+struct MemoryStats
+{
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+    uint32_t allocationCount = 0;
+    //Allocated from the driver, the blocks and the dedicated allocations
+    VkDeviceSize reservedBytes = 0;
+    //Nodes given to the resources, their size is rounded to a power of two
+    VkDeviceSize allocatedBytes = 0;
+    //Requested by the resources
+    VkDeviceSize usedBytes = 0;
+};
+
+/*@brief : Sub-allocates the buffers and images from large blocks of each memory type instead of calling
+*          vkAllocateMemory for every resource, which is slow and limited to maxMemoryAllocationCount.
+*          A node of a block is aligned on its size, a power of two, which covers the alignment of the
+*          resource. The optimal images get their own blocks when bufferImageGranularity is larger
+*          than a node. The resources larger than a block get a dedicated allocation. The host visible
+*          blocks stay mapped, the allocations must not be mapped again
+*/
+class MemoryAllocator : public VkElement
+{
+public:
+    static constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+    // Smaller for the small heaps, a block is at most an eighth of its heap
+    static constexpr VkDeviceSize MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+
+private:
+    using VkElement::pCore_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<MemoryBlock>> blocks_;
+    //By memory type
+    std::vector<VkDeviceSize> blockSizes_;
+    std::vector<MemoryStats> stats_;
+    bool separateOptimalImages_ = false;
+
+    bool isHostVisible(uint32_t memoryType) const;
+    // Must be called with the mutex locked
+    MemoryBlock& createBlock(uint32_t memoryType, bool isOptimalImage);
+    // Take a free node of the order from the block, splitting a larger one if needed
+    static bool allocateFromBlock(MemoryBlock& block, uint32_t order, MemoryAllocation& allocation);
+    void releaseEmptyBlock(MemoryBlock& block);
+
+public:
+    MemoryAllocator(const VulkanCore* pCore);
+    MemoryAllocator(const MemoryAllocator&) = delete;
+    MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+    // After the creation of the logical device
+    virtual void create() override;
+    // Free every block, the allocations still used are reported
+    virtual void destroy() override;
+
+    // Thread safe. Throw if no memory type matches or the device is out of memory
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                              bool isOptimalImage);
+    // Thread safe, nothing is done for an empty allocation. The allocation is reset
+    void free(MemoryAllocation& allocation);
+
+    // Totals of every memory type
+    MemoryStats getStats() const;
+    void logStats() const;
+
+    virtual ~MemoryAllocator() override;
+};
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "renderer/VkElement.h"
+#include "renderer/memory/MemoryAllocator.h"
+#include <deque>
+#include <vector>
+
+namespace renderer
+{
+
+// Part of the staging buffer written by the CPU, the copy reads it from offset
+struct StagingRange
+{
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* pMapped = nullptr;
+};
+
+/*@brief : Host visible buffer, mapped once, through which every upload goes. The ranges are given one
+*          after the other and wrap around at the end of the buffer. A batch of ranges is reused once the
+*          fence of the submission reading it is signaled, the ring waits for the oldest batch when it is
+*          full. A range larger than the ring, or a ring full of unsubmitted ranges, grows the buffer :
+*          the previous one is destroyed with the next batch. The batches also track the submissions of the
+*          uploads, which can be polled. Only from the thread owning the vulkan core
+*/
+class StagingRing : public VkElement
+{
+public:
+    static constexpr VkDeviceSize INITIAL_SIZE = 16 * 1024 * 1024;
+    // Covers the texel size and the 4 bytes alignment of the buffer to image copies
+    static constexpr VkDeviceSize DEFAULT_ALIGNMENT = 16;
+
+private:
+    struct StagingBuffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation memory;
+    };
+
+    struct Batch
+    {
+        uint64_t id;
+        VkFence fence;
+        //Bytes of the ring used by the batch, with the padding
+        VkDeviceSize size;
+        //Buffers replaced by a larger one while the batch was written
+        std::vector<StagingBuffer> retiredBuffers;
+        //Freed with the batch, VK_NULL_HANDLE if the caller frees it
+        VkCommandPool commandPool;
+        VkCommandBuffer commandBuffer;
+    };
+
+    using VkElement::pCore_;
+
+    StagingBuffer current_;
+    VkDeviceSize capacity_ = 0;
+    //Next byte given, the used bytes end here
+    VkDeviceSize head_ = 0;
+    VkDeviceSize usedSize_ = 0;
+    //Given since the last batch, part of usedSize_
+    VkDeviceSize unsubmittedSize_ = 0;
+    std::vector<StagingBuffer> retiredBuffers_;
+
+    std::deque<Batch> batches_;
+    std::vector<VkFence> freeFences_;
+    uint64_t lastBatchId_ = 0;
+
+    void createBuffer(VkDeviceSize capacity);
+    void destroyBuffer(StagingBuffer& buffer);
+    // Reuse the ranges of the oldest batch, waiting for its fence if wait is true.
+    // Return false if the batch is still read
+    bool releaseOldestBatch(bool wait);
+
+public:
+    StagingRing(const VulkanCore* pCore);
+    StagingRing(const StagingRing&) = delete;
+    StagingRing& operator=(const StagingRing&) = delete;
+
+    virtual void create() override;
+    // Wait for every batch
+    virtual void destroy() override;
+
+    // size bytes to write at pMapped, aligned on alignment, a power of two
+    StagingRange allocate(VkDeviceSize size, VkDeviceSize alignment = DEFAULT_ALIGNMENT);
+    // Close the batch of the ranges given since the last call. The returned fence must be given to the
+    // submission reading them, they are reused once it is signaled. The fence belongs to the ring, it is
+    // reset and given again once the batch is released : wait for the batch with its id instead.
+    // The command buffer of the submission, if any, is freed with the batch
+    VkFence endBatch(VkCommandPool commandPool = VK_NULL_HANDLE, VkCommandBuffer commandBuffer = VK_NULL_HANDLE);
+    // Id of the batch closed by the last call to endBatch
+    uint64_t getLastBatchId() const;
+    // Wait for the submissions reading the batches up to batchId and reuse their ranges
+    void waitForBatch(uint64_t batchId);
+    // Return true if the submissions of the batches up to batchId are complete, without waiting
+    bool isBatchComplete(uint64_t batchId);
+
+    VkDeviceSize getCapacity() const;
+
+    virtual ~StagingRing() override;
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer/texture/Texture2D.h"
+#include <vector>
 
 
 namespace renderer
@@ -11,19 +12,28 @@ class MaterialTexture : public Texture2D
 protected:
 
     std::string path_;
+    //Decoded RGBA pixels given at the construction, released once uploaded
+    std::vector<unsigned char> pixels_;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
     VkSampler sampler_;
     uint32_t mipLevels_ = 1;
 
     virtual void createImage()override;
+    void uploadPixels(const unsigned char* pPixels, int32_t texWidth, int32_t texHeight);
     virtual void createSampler();
     virtual void createImageView()override;
-    void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight,
-                         uint32_t mipLevels);
+    // Record the blits of the mip levels, the first one in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    void generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth,
+                         int32_t texHeight, uint32_t mipLevels);
 
 public:
     MaterialTexture(const VulkanCore* pCore);
     MaterialTexture(const VulkanCore* pCore, const VkFormat& format);
     MaterialTexture(const VulkanCore* pCore, const std::string& path, const VkFormat& format);
+    // Texture of an image already decoded, 4 bytes per pixel
+    MaterialTexture(const VulkanCore* pCore, std::vector<unsigned char> pixels, uint32_t width, uint32_t height,
+                    const VkFormat& format);
 
     virtual void create() override;
     virtual void destroy() override;
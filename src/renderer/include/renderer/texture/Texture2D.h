@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer/VkElement.h"
+#include "renderer/memory/MemoryAllocator.h"
 #include <string>
 
 namespace renderer
@@ -15,7 +16,7 @@ protected:
 
     VkImage image_;
     VkImageView imageView_;
-    VkDeviceMemory imageMemory_;
+    MemoryAllocation imageMemory_;
     VkFormat format_;
 
     virtual void createImage() = 0;
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "renderer/texture/MaterialTexture.h"
+#include "loader/ThreadPool.h"
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace renderer
+{
+
+/*@brief : Textures of the materials, every image is decoded and uploaded once. The files are found by
+*          their canonical path, then by a hash of their content so that copies of an image under other
+*          names share a texture. The images are decoded on worker threads, uploaded on the thread owning
+*          the vulkan core
+*/
+class TextureCache
+{
+private:
+    struct DecodedImage
+    {
+        std::vector<unsigned char> pixels;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        //Canonical path of a file with the same content, this one is not decoded
+        std::string sameContentAs;
+    };
+
+    const VulkanCore* pCore_;
+
+    std::mutex mutex_;
+    //Images decoding or decoded and not uploaded yet, by canonical path
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<DecodedImage>>> pendingImages_;
+    //First canonical path read with each content hash
+    std::unordered_map<uint64_t, std::string> contentOwners_;
+    //nullptr for the files that can't be decoded, they are not read again
+    std::unordered_map<std::string, std::shared_ptr<MaterialTexture>> textures_;
+    std::shared_ptr<MaterialTexture> pWhiteTexture_;
+
+    //Declared last so that the workers are joined before the maps they fill are destroyed
+    ThreadPool decodePool_;
+
+    std::shared_ptr<DecodedImage> decode(const std::string& canonicalPath);
+    // Must be called with the mutex locked
+    std::shared_future<std::shared_ptr<DecodedImage>> enqueueDecode(const std::string& canonicalPath);
+    static std::string getCanonicalPath(const std::string& path);
+
+public:
+    TextureCache(const VulkanCore* pCore);
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+    ~TextureCache();
+
+    // Start decoding the image on a worker unless it is cached or decoding already. Thread safe
+    void prefetch(const std::string& path);
+    // Texture of the image, uploaded on the first call and decoded here if it wasn't prefetched.
+    // nullptr if the file can't be read or decoded. Only from the thread owning the vulkan core
+    std::shared_ptr<MaterialTexture> getTexture(const std::string& path);
+    // Single white pixel, sampled by the materials without texture
+    std::shared_ptr<MaterialTexture> getWhiteTexture();
+    // Destroy every texture, before the device is destroyed
+    void clear();
+};
+
+}
@@ -1,22 +1,80 @@
 #include "renderer/Material.h"
+#include "renderer/VulkanCore.h"
+
 namespace renderer
 {
 
-Material::Material(const VulkanCore* pCore):
+Material::Material(const VulkanCore* pCore, const std::string& name, const glm::vec3& diffuseColor,
+                   const std::shared_ptr<MaterialTexture>& pAlbedo):
     VkElement(pCore),
-    albedo(pCore)
+    name_(name),
+    diffuseColor_(diffuseColor),
+    pAlbedo_(pAlbedo)
 {
 
 }
 
 void Material::create()
 {
+    if(isCreated_)
+    {
+        destroy();
+    }
+
+    const VkDescriptorSetLayout& layout = pCore_->getMaterialSetLayout();
+    VkDescriptorSetAllocateInfo descAlloc = {};
+    descAlloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descAlloc.descriptorPool = pCore_->getMaterialDescriptorPool();
+    descAlloc.descriptorSetCount = 1;
+    descAlloc.pSetLayouts = &layout;
+
+    if(vkAllocateDescriptorSets(pCore_->getDevice(), &descAlloc, &descriptorSet_) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate material descriptor set!");
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = pAlbedo_->getImageView();
+    imageInfo.sampler = pAlbedo_->getSampler();
+
+    VkWriteDescriptorSet writeInfo = {};
+    writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeInfo.dstSet = descriptorSet_;
+    writeInfo.dstBinding = 0; //binding index in "layout(set = 1, binding = 0)"
+    writeInfo.dstArrayElement = 0;
+    writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writeInfo.descriptorCount = 1;
+    writeInfo.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(pCore_->getDevice(), 1, &writeInfo, 0, nullptr);
     isCreated_ = true;
 }
 
 void Material::destroy()
 {
-    isCreated_ = false;
+    if(isCreated_)
+    {
+        //The pool is created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+        vkFreeDescriptorSets(pCore_->getDevice(), pCore_->getMaterialDescriptorPool(), 1, &descriptorSet_);
+        descriptorSet_ = VK_NULL_HANDLE;
+        isCreated_ = false;
+    }
+}
+
+const std::string& Material::getName() const
+{
+    return name_;
+}
+
+const glm::vec3& Material::getDiffuseColor() const
+{
+    return diffuseColor_;
+}
+
+const VkDescriptorSet& Material::getDescriptorSet() const
+{
+    return descriptorSet_;
 }
 
 Material::~Material()
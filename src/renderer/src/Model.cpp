@@ -1,12 +1,84 @@
 #include "renderer/Model.h"
 #include "renderer/VulkanCore.h"
 #include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <plog/Log.h>
 
 namespace renderer
 {
 
+namespace
+{
+
+//Write the indices at pDestination on indexSize bytes each
+void writeIndices(const std::vector<uint32_t>& indices, uint32_t indexSize, char* pDestination)
+{
+    if(indexSize == sizeof(uint32_t))
+    {
+        memcpy(pDestination, indices.data(), indices.size() * sizeof(uint32_t));
+        return;
+    }
+
+    uint16_t* pShortIndices = reinterpret_cast<uint16_t*>(pDestination);
+
+    for(size_t idx = 0; idx < indices.size(); idx++)
+    {
+        pShortIndices[idx] = static_cast<uint16_t>(indices[idx]);
+    }
+}
+
+VkDeviceSize getVertexStride(E_VertexFormat format)
+{
+    return format == COMPACT_VERTEX ? sizeof(data::CompactVertexAttribute) : sizeof(data::VertexAttribute);
+}
+
+//Indices of the mesh and of its levels of detail
+size_t getIndexCount(const data::Mesh& mesh)
+{
+    size_t indexCount = mesh.indices.size();
+
+    for(const data::MeshLod& lod : mesh.lods)
+    {
+        indexCount += lod.indices.size();
+    }
+
+    return indexCount;
+}
+
+MeshInfo createMeshInfo(const data::Mesh& mesh)
+{
+    MeshInfo info;
+    info.name = mesh.name;
+    info.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    info.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    info.material = mesh.material;
+
+    glm::vec3 minPosition = mesh.vertices.empty() ? glm::vec3(0.0f) : mesh.vertices[0].pos;
+    glm::vec3 maxPosition = minPosition;
+
+    for(const data::VertexAttribute& vertex : mesh.vertices)
+    {
+        minPosition = glm::min(minPosition, vertex.pos);
+        maxPosition = glm::max(maxPosition, vertex.pos);
+    }
+
+    info.boundsCenter = (minPosition + maxPosition) * 0.5f;
+
+    for(const data::VertexAttribute& vertex : mesh.vertices)
+    {
+        info.boundsRadius = std::max(info.boundsRadius, glm::length(vertex.pos - info.boundsCenter));
+    }
+
+    return info;
+}
+
+}
+
+constexpr VkDeviceSize Model::MAX_PACKED_SIZE;
+
 Model::Model(const VulkanCore* pCore):
     VkElement(pCore)
 {
@@ -27,14 +99,22 @@ void Model::create()
         destroy();
     }
 
-    meshesData_.resize(meshes_.size());
+    //Only held for the upload if the model releases its meshes. They are not loaded again here, on the
+    //thread owning the core, the owner of the model restores them first
+    std::vector<data::MeshPtr> meshes = lockHostMeshes();
 
-    for(size_t idx = 0; idx < meshes_.size(); idx++)
+    if(meshes.size() != meshInfos_.size())
     {
-        createMeshData(meshes_[idx], meshesData_[idx]);
-        //setMaterialForMesh(meshes_[idx], *defaultMaterial);
+        PLOGE << "The meshes of " << name_ << " were released, they must be restored before its creation"
+              << '\n';
+        meshes.clear();
     }
 
+    meshesData_.resize(meshes.size());
+    UploadBatch batch(pCore_, true);
+
+    createMeshBuffers(meshes, 0, batch);
+    submitUpload(batch, 0, 0);
     isCreated_ = true;
 }
 
@@ -42,41 +122,265 @@ void Model::destroy()
 {
     if(isCreated_)
     {
-        for(auto meshData : meshesData_)
+        //The copies and the acquisitions may still use the buffers
+        StagingRing& stagingRing = pCore_->getStagingRing();
+        stagingRing.waitForBatch(stagingRing.getLastBatchId());
+        pendingUploads_.clear();
+        destroyMeshBuffers();
+        meshesData_.clear();
+        isCreated_ = false;
+    }
+}
+
+void Model::assignMesh(const std::vector<data::MeshPtr>& meshes)
+{
+    meshInfos_.clear();
+    meshes_.clear();
+    hostMeshes_.clear();
+
+    appendMeshes(meshes);
+}
+
+void Model::appendMesh(const data::MeshPtr& mesh)
+{
+    appendMeshes(std::vector<data::MeshPtr>(1, mesh));
+}
+
+void Model::appendMeshes(const std::vector<data::MeshPtr>& meshes)
+{
+    for(const data::MeshPtr& mesh : meshes)
+    {
+        meshInfos_.push_back(createMeshInfo(*mesh));
+        hostMeshes_.push_back(mesh);
+
+        if(residency_ == KEEP_HOST_MESHES)
         {
-            destroyMeshData(meshData);
+            meshes_.push_back(mesh);
         }
+    }
 
-        isCreated_ = false;
+    if(!isCreated_)
+    {
+        return;
+    }
+
+    //Packed in buffers of their own, the buffers of the previous meshes may be drawn meanwhile
+    UploadBatch batch(pCore_, true);
+    size_t firstMesh = meshesData_.size();
+    size_t firstBuffers = meshBuffers_.size();
+    meshesData_.resize(firstMesh + meshes.size());
+    createMeshBuffers(meshes, firstMesh, batch);
+    submitUpload(batch, firstMesh, firstBuffers);
+}
+
+void Model::submitUpload(UploadBatch& batch, size_t firstMesh, size_t firstBuffers)
+{
+    PendingUpload upload;
+    upload.batchId = batch.submitAsync();
+    upload.firstMesh = firstMesh;
+    upload.meshCount = meshesData_.size() - firstMesh;
+    upload.firstBuffers = firstBuffers;
+    upload.buffersCount = meshBuffers_.size() - firstBuffers;
+
+    if(upload.meshCount > 0)
+    {
+        pendingUploads_.push_back(upload);
+    }
+}
+
+bool Model::updateUploads()
+{
+    if(pendingUploads_.empty())
+    {
+        return false;
+    }
+
+    StagingRing& stagingRing = pCore_->getStagingRing();
+    //Ordered before the draws recorded afterwards, submitted on the same queue
+    UploadBatch acquireBatch(pCore_, false);
+    bool isUploaded = false;
+
+    while(!pendingUploads_.empty() && stagingRing.isBatchComplete(pendingUploads_.front().batchId))
+    {
+        const PendingUpload& upload = pendingUploads_.front();
+
+        for(size_t idxBuffers = upload.firstBuffers; idxBuffers < upload.firstBuffers + upload.buffersCount;
+                idxBuffers++)
+        {
+            const MeshBuffers& buffers = meshBuffers_[idxBuffers];
+            acquireBatch.acquireBuffer(buffers.vertexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                       VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+            if(buffers.indexBuffer != VK_NULL_HANDLE)
+            {
+                acquireBatch.acquireBuffer(buffers.indexBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                           VK_ACCESS_INDEX_READ_BIT);
+            }
+        }
+
+        for(size_t idxMesh = upload.firstMesh; idxMesh < upload.firstMesh + upload.meshCount; idxMesh++)
+        {
+            meshesData_[idxMesh].isUploaded = true;
+        }
+
+        pendingUploads_.pop_front();
+        isUploaded = true;
     }
+
+    acquireBatch.submitAsync();
+    return isUploaded;
 }
 
-void Model::assignMesh(const std::vector<data::Mesh>& meshes)
+void Model::setResidency(E_MeshResidency residency)
 {
-    meshes_.assign(meshes.begin(), meshes.end());
+    residency_ = residency;
+
+    if(residency_ == RELEASE_HOST_MESHES)
+    {
+        //Freed here unless a CPU consumer still holds them
+        std::vector<data::MeshPtr>().swap(meshes_);
+    }
+    else
+    {
+        meshes_ = getHostMeshes();
+    }
+}
+
+E_MeshResidency Model::getResidency() const
+{
+    return residency_;
 }
 
-void Model::destroyMeshData(MeshData& meshData)
+void Model::setMeshSource(const MeshSource& meshSource)
 {
-    vkDestroyBuffer(pCore_->getDevice(), meshData.vertexBuffer, nullptr);
-    vkFreeMemory(pCore_->getDevice(), meshData.vertexBufferMemory, nullptr);
-    vkDestroyBuffer(pCore_->getDevice(), meshData.vertexIndexBuffer,
-                    nullptr);
-    vkFreeMemory(pCore_->getDevice(), meshData.vertexIndexBufferMemory,
-                 nullptr);
-    meshData.isAllocated = false;
+    meshSource_ = meshSource;
 }
 
-void Model::setMaterialForMesh(const data::Mesh& mesh,
-                               const Material& material)
+const Model::MeshSource& Model::getMeshSource() const
 {
-    auto itFound = std::find_if(meshes_.begin(),
-                                meshes_.end(), [&](data::Mesh other)
+    return meshSource_;
+}
+
+std::vector<data::MeshPtr> Model::lockHostMeshes() const
+{
+    std::vector<data::MeshPtr> meshes;
+    meshes.reserve(hostMeshes_.size());
+
+    for(const std::weak_ptr<const data::Mesh>& hostMesh : hostMeshes_)
     {
-        return mesh.name == other.name;
-    });
-    uint32_t idx = std::distance(meshes_.begin(), itFound);
-    setMaterialForMeshData(meshesData_[idx], material);
+        data::MeshPtr mesh = hostMesh.lock();
+
+        if(!mesh)
+        {
+            break;
+        }
+
+        meshes.push_back(mesh);
+    }
+
+    return meshes;
+}
+
+bool Model::hasHostMeshes() const
+{
+    return lockHostMeshes().size() == hostMeshes_.size();
+}
+
+bool Model::restoreHostMeshes(const std::vector<data::MeshPtr>& meshes) const
+{
+    //The file may have changed since, the meshes must still match their infos
+    if(meshes.size() != meshInfos_.size())
+    {
+        PLOGE << "The meshes of " << name_ << " changed since they were loaded" << '\n';
+        return false;
+    }
+
+    for(size_t idxMesh = 0; idxMesh < meshes.size(); idxMesh++)
+    {
+        if(meshes[idxMesh]->vertices.size() != meshInfos_[idxMesh].vertexCount ||
+                meshes[idxMesh]->indices.size() != meshInfos_[idxMesh].indexCount)
+        {
+            PLOGE << "The meshes of " << name_ << " changed since they were loaded" << '\n';
+            return false;
+        }
+    }
+
+    hostMeshes_.assign(meshes.begin(), meshes.end());
+    return true;
+}
+
+std::vector<data::MeshPtr> Model::getHostMeshes() const
+{
+    std::vector<data::MeshPtr> meshes = lockHostMeshes();
+
+    if(meshes.size() == hostMeshes_.size())
+    {
+        return meshes;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    meshes.clear();
+
+    if(!meshSource_ || !meshSource_(meshes) || !restoreHostMeshes(meshes))
+    {
+        PLOGE << "The meshes of " << name_ << " can't be loaded again" << '\n';
+        return std::vector<data::MeshPtr>();
+    }
+
+    PLOGD << "Meshes of " << name_ << " loaded again in "
+          << std::chrono::duration<float, std::chrono::milliseconds::period>
+          (std::chrono::high_resolution_clock::now() - startTime).count() << " ms" << '\n';
+
+    return meshes;
+}
+
+bool Model::selectLods(const glm::vec3& cameraPosition, float pixelsPerUnit, float maxPixelError)
+{
+    bool isModified = false;
+
+    for(size_t idxMesh = 0; idxMesh < meshesData_.size(); idxMesh++)
+    {
+        MeshData& meshData = meshesData_[idxMesh];
+        const MeshInfo& info = meshInfos_[idxMesh];
+        //Distance to the closest point of the bounding sphere, clamped when the camera is inside
+        float distance = std::max(glm::length(cameraPosition - info.boundsCenter) - info.boundsRadius, 0.01f);
+        uint32_t selectedLod = 0;
+
+        for(uint32_t idxLod = 1; idxLod < meshData.lods.size(); idxLod++)
+        {
+            if(meshData.lods[idxLod].error * pixelsPerUnit / distance > maxPixelError)
+            {
+                break;
+            }
+
+            selectedLod = idxLod;
+        }
+
+        if(selectedLod != meshData.selectedLod)
+        {
+            meshData.selectedLod = selectedLod;
+            isModified = true;
+        }
+    }
+
+    return isModified;
+}
+
+void Model::destroyMeshBuffers()
+{
+    for(MeshBuffers& buffers : meshBuffers_)
+    {
+        pCore_->getUtils().destroyBuffer(buffers.vertexBuffer, buffers.vertexBufferMemory);
+        pCore_->getUtils().destroyBuffer(buffers.indexBuffer, buffers.indexBufferMemory);
+    }
+
+    meshBuffers_.clear();
+}
+
+void Model::setMaterialForMesh(size_t idxMesh, const Material& material)
+{
+    //Several meshes of a file may have the same name, they are found by index
+    setMaterialForMeshData(meshesData_[idxMesh], material);
 }
 
 void Model::setMaterialForMeshData(MeshData& meshData,
@@ -85,75 +389,153 @@ void Model::setMaterialForMeshData(MeshData& meshData,
     meshData.material = &material;
 }
 
-void Model::createMeshData(const data::Mesh& mesh, MeshData& meshData)
+void Model::createMeshBuffers(const std::vector<data::MeshPtr>& meshes, size_t firstMesh, UploadBatch& batch)
 {
-    if(meshData.isAllocated)
+    VkDeviceSize vertexStride = getVertexStride(vertexFormat_);
+    size_t idxBegin = 0;
+
+    while(idxBegin < meshes.size())
     {
-        destroyMeshData(meshData);
-    }
+        //The meshes are packed until a buffer would exceed MAX_PACKED_SIZE, a larger mesh is packed alone
+        VkDeviceSize vertexSize = meshes[idxBegin]->vertices.size() * vertexStride;
+        VkDeviceSize indexSize = getIndexCount(*meshes[idxBegin]) * meshes[idxBegin]->getIndexSize();
+        size_t idxEnd = idxBegin + 1;
+
+        while(idxEnd < meshes.size())
+        {
+            vertexSize += meshes[idxEnd]->vertices.size() * vertexStride;
+            indexSize += getIndexCount(*meshes[idxEnd]) * meshes[idxEnd]->getIndexSize();
+
+            //The 32 bits indices may be moved by 2 bytes to be aligned
+            if(vertexSize > MAX_PACKED_SIZE || indexSize + sizeof(uint16_t) > MAX_PACKED_SIZE)
+            {
+                break;
+            }
 
-    createVertexBuffer(mesh, meshData);
-    createVertexIndexBuffer(mesh, meshData);
-    meshData.isAllocated = true;
+            idxEnd++;
+        }
+
+        createPackedBuffers(meshes, idxBegin, idxEnd, firstMesh, batch);
+        idxBegin = idxEnd;
+    }
 }
 
-void Model::createVertexBuffer(const data::Mesh& mesh, MeshData& meshData)
+void Model::createPackedBuffers(const std::vector<data::MeshPtr>& meshes, size_t idxBegin, size_t idxEnd,
+                                size_t firstMesh, UploadBatch& batch)
 {
-    VkDeviceSize bufferSize = sizeof(mesh.vertices[0]) *
-                              mesh.vertices.size();
-    VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    pCore_->getUtils().createBuffer(bufferSize, usage, properties,
-                                    stagingBuffer, stagingBufferMemory);
-    void* pData;//Contains a pointer to the mapped memory
-    //Documentation : memory must have been created with a memory type that reports VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-    //                  flags is reserved for future use of the vulkanAPI.
-    vkMapMemory(pCore_->getDevice(), stagingBufferMemory, 0, bufferSize, 0,
-                &pData);
-    memcpy(pData, meshes_[0].vertices.data(), (size_t)bufferSize);
-    vkUnmapMemory(pCore_->getDevice(), stagingBufferMemory);
-    pCore_->getUtils().createBuffer(bufferSize,
+    MeshBuffers buffers;
+    uint32_t vertexCount = 0;
+    //The 16 bits indices are at the beginning of the index buffer, followed by the 32 bits ones
+    uint32_t shortIndexCount = 0;
+    uint32_t intIndexCount = 0;
+
+    for(size_t idx = idxBegin; idx < idxEnd; idx++)
+    {
+        const data::Mesh& mesh = *meshes[idx];
+        MeshData& meshData = meshesData_[firstMesh + idx];
+        meshData.buffersIndex = static_cast<uint32_t>(meshBuffers_.size());
+        meshData.vertexOffset = vertexCount;
+        meshData.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        meshData.isPointCloud = mesh.indices.empty();
+        meshData.isUploaded = false;
+        meshData.selectedLod = 0;
+        vertexCount += meshData.vertexCount;
+
+        if(vertexFormat_ == COMPACT_VERTEX)
+        {
+            meshData.quantizationBounds = data::computeQuantizationBounds(mesh.vertices);
+        }
+
+        //The levels of detail share the vertices, their indices follow the ones of the mesh
+        bool isShort = mesh.getIndexSize() == sizeof(uint16_t);
+        uint32_t& indexCount = isShort ? shortIndexCount : intIndexCount;
+        meshData.indexType = isShort ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        meshData.lods.resize(meshData.isPointCloud ? 1 : mesh.lods.size() + 1);
+        meshData.lods[0].firstIndex = indexCount;
+        meshData.lods[0].indexCount = static_cast<uint32_t>(mesh.indices.size());
+        meshData.lods[0].error = 0.0f;
+        indexCount += meshData.lods[0].indexCount;
+
+        for(size_t idxLod = 1; idxLod < meshData.lods.size(); idxLod++)
+        {
+            LodRange& range = meshData.lods[idxLod];
+            range.firstIndex = indexCount;
+            range.indexCount = static_cast<uint32_t>(mesh.lods[idxLod - 1].indices.size());
+            range.error = mesh.lods[idxLod - 1].error;
+            indexCount += range.indexCount;
+        }
+    }
+
+    //Aligned on the size of an index for vkCmdBindIndexBuffer
+    VkDeviceSize intIndexOffset = (shortIndexCount * sizeof(uint16_t) + sizeof(uint32_t) - 1) &
+                                  ~static_cast<VkDeviceSize>(sizeof(uint32_t) - 1);
+    VkDeviceSize indexBufferSize = intIndexCount > 0 ? intIndexOffset + intIndexCount * sizeof(uint32_t) :
+                                   shortIndexCount * sizeof(uint16_t);
+    VkDeviceSize vertexStride = getVertexStride(vertexFormat_);
+    VkDeviceSize vertexBufferSize = vertexCount * vertexStride;
+
+    pCore_->getUtils().createBuffer(vertexBufferSize,
                                     VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, meshData.vertexBuffer,
-                                    meshData.vertexBufferMemory);
-    pCore_->getUtils().copyBuffer(stagingBuffer, meshData.vertexBuffer,
-                                  bufferSize);
-    vkDestroyBuffer(pCore_->getDevice(), stagingBuffer, nullptr);
-    vkFreeMemory(pCore_->getDevice(), stagingBufferMemory, nullptr);
-    PLOGD << "Vertex Buffer Created for mesh : " << name_ << '\n';
-}
-
-void Model::createVertexIndexBuffer(const data::Mesh& mesh,
-                                    MeshData& meshData)
-{
-    PLOGD << "Creating and Allocating Index Buffer for mesh : " << name_ << '\n';
-    VkDeviceSize bufferSize = sizeof(mesh.indices[0]) * mesh.indices.size();
-    VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    pCore_->getUtils().createBuffer(bufferSize, usage, properties,
-                                    stagingBuffer, stagingBufferMemory);
-    void* pData;
-    vkMapMemory(pCore_->getDevice(), stagingBufferMemory, 0, bufferSize, 0,
-                &pData);
-    memcpy(pData, mesh.indices.data(), (size_t)bufferSize);
-    vkUnmapMemory(pCore_->getDevice(), stagingBufferMemory);
-    pCore_->getUtils().createBuffer(bufferSize,
-                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, meshData.vertexIndexBuffer,
-                                    meshData.vertexIndexBufferMemory);
-    pCore_->getUtils().copyBuffer(stagingBuffer, meshData.vertexIndexBuffer,
-                                  bufferSize);
-    vkDestroyBuffer(pCore_->getDevice(), stagingBuffer, nullptr);
-    vkFreeMemory(pCore_->getDevice(), stagingBufferMemory, nullptr);
-    PLOGD << "Index Buffer Created for mesh : " << name_ << '\n';
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffers.vertexBuffer,
+                                    buffers.vertexBufferMemory, VK_SHARING_MODE_EXCLUSIVE);
+
+    //Written straight to the staging ring, one copy for the whole buffer
+    char* pVertices = static_cast<char*>(batch.stageBufferCopy(vertexBufferSize, buffers.vertexBuffer));
+    std::vector<data::CompactVertexAttribute> compactVertices;
+
+    for(size_t idx = idxBegin; idx < idxEnd; idx++)
+    {
+        const data::Mesh& mesh = *meshes[idx];
+        const MeshData& meshData = meshesData_[firstMesh + idx];
+        char* pDestination = pVertices + meshData.vertexOffset * vertexStride;
+
+        if(vertexFormat_ == COMPACT_VERTEX)
+        {
+            data::quantizeVertices(mesh.vertices, meshData.quantizationBounds, compactVertices);
+            memcpy(pDestination, compactVertices.data(),
+                   compactVertices.size() * sizeof(data::CompactVertexAttribute));
+        }
+        else
+        {
+            memcpy(pDestination, mesh.vertices.data(), mesh.vertices.size() * sizeof(data::VertexAttribute));
+        }
+    }
+
+    //Destroying a null handle does nothing, the point clouds have no index buffer
+    if(indexBufferSize > 0)
+    {
+        pCore_->getUtils().createBuffer(indexBufferSize,
+                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffers.indexBuffer,
+                                        buffers.indexBufferMemory, VK_SHARING_MODE_EXCLUSIVE);
+        char* pIndices = static_cast<char*>(batch.stageBufferCopy(indexBufferSize, buffers.indexBuffer));
+
+        for(size_t idx = idxBegin; idx < idxEnd; idx++)
+        {
+            const data::Mesh& mesh = *meshes[idx];
+            MeshData& meshData = meshesData_[firstMesh + idx];
+            uint32_t indexSize = mesh.getIndexSize();
+            meshData.indexBufferOffset = meshData.indexType == VK_INDEX_TYPE_UINT16 ? 0 : intIndexOffset;
+            char* pRegion = pIndices + meshData.indexBufferOffset;
+
+            if(meshData.isPointCloud)
+            {
+                continue;
+            }
+
+            writeIndices(mesh.indices, indexSize, pRegion + meshData.lods[0].firstIndex * indexSize);
+
+            for(size_t idxLod = 1; idxLod < meshData.lods.size(); idxLod++)
+            {
+                writeIndices(mesh.lods[idxLod - 1].indices, indexSize,
+                             pRegion + meshData.lods[idxLod].firstIndex * indexSize);
+            }
+        }
+    }
+
+    meshBuffers_.push_back(buffers);
+    PLOGD << idxEnd - idxBegin << " mesh(es) of " << name_ << " packed in " << vertexBufferSize
+          << " bytes of vertices and " << indexBufferSize << " bytes of indices" << '\n';
 }
 
 //void Model::setDefaultMaterial(const Material &material)
@@ -161,6 +543,28 @@ void Model::createVertexIndexBuffer(const data::Mesh& mesh,
 //    defaultMaterial = &material;
 //}
 
+E_VertexFormat Model::getVertexFormat() const
+{
+    return vertexFormat_;
+}
+
+void Model::setVertexFormat(E_VertexFormat format)
+{
+    if(format == vertexFormat_)
+    {
+        return;
+    }
+
+    vertexFormat_ = format;
+
+    if(isCreated_)
+    {
+        //Held until the buffers are created again
+        std::vector<data::MeshPtr> meshes = getHostMeshes();
+        create();
+    }
+}
+
 const std::string& Model::getName() const
 {
     return name_;
@@ -176,9 +580,14 @@ const std::vector<MeshData>& Model::getMeshData() const
     return meshesData_;
 }
 
-const std::vector<data::Mesh>& Model::getMeshes() const
+const std::vector<MeshBuffers>& Model::getMeshBuffers() const
+{
+    return meshBuffers_;
+}
+
+const std::vector<MeshInfo>& Model::getMeshInfos() const
 {
-    return meshes_;
+    return meshInfos_;
 }
 
 }
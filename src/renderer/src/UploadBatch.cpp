@@ -0,0 +1,211 @@
+#include "renderer/UploadBatch.h"
+#include "renderer/VulkanCore.h"
+#include <cstring>
+
+namespace renderer
+{
+
+namespace
+{
+
+//Releases the buffer on the transfer queue, and acquires it with the same barrier on the graphics queue
+VkBufferMemoryBarrier createTransferBarrier(const VulkanCore* pCore, VkBuffer buffer, VkAccessFlags dstAccess)
+{
+    QueueFamilyIndices indices = pCore->getPhysicalDeviceProperties().getQueueFamilyIndices();
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    if(indices.transferAvailable())
+    {
+        barrier.srcQueueFamilyIndex = static_cast<uint32_t>(indices.transferFamily);
+        barrier.dstQueueFamilyIndex = static_cast<uint32_t>(indices.graphicsFamily);
+    }
+
+    return barrier;
+}
+
+}
+
+UploadBatch::UploadBatch(const VulkanCore* pCore, bool useTransfer):
+    pCore_(pCore),
+    useTransfer_(useTransfer),
+    releasesBuffers_(useTransfer &&
+                     pCore->getPhysicalDeviceProperties().getQueueFamilyIndices().transferAvailable())
+{
+}
+
+UploadBatch::~UploadBatch()
+{
+    submit();
+}
+
+VkCommandBuffer UploadBatch::beginCommandBuffer()
+{
+    VkCommandBufferAllocateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    bufferInfo.commandBufferCount = 1;
+    bufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    bufferInfo.commandPool = useTransfer_ ? pCore_->getCommandPoolTransfer() : pCore_->getCommandPool();
+
+    VkCommandBuffer commandBuffer;
+
+    if(vkAllocateCommandBuffers(pCore_->getDevice(), &bufferInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate upload command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    return commandBuffer;
+}
+
+VkCommandBuffer UploadBatch::getCommandBuffer()
+{
+    if(commandBuffer_ == VK_NULL_HANDLE)
+    {
+        commandBuffer_ = beginCommandBuffer();
+    }
+
+    commandCount_++;
+    return commandBuffer_;
+}
+
+void UploadBatch::flush()
+{
+    if(commandBuffer_ == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if(!releaseBarriers_.empty())
+    {
+        vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, static_cast<uint32_t>(releaseBarriers_.size()),
+                             releaseBarriers_.data(), 0, nullptr);
+        releaseBarriers_.clear();
+    }
+
+    vkEndCommandBuffer(commandBuffer_);
+
+    VkSubmitInfo subInfo = {};
+    subInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    subInfo.commandBufferCount = 1;
+    subInfo.pCommandBuffers = &commandBuffer_;
+
+    StagingRing& stagingRing = pCore_->getStagingRing();
+    //The staged ranges are reused and the command buffer freed once the fence of the ring is signaled
+    vkQueueSubmit(useTransfer_ ? pCore_->getTransfertQueue() : pCore_->getGraphicsQueue(), 1, &subInfo,
+                  stagingRing.endBatch(useTransfer_ ? pCore_->getCommandPoolTransfer() : pCore_->getCommandPool(),
+                                       commandBuffer_));
+    lastBatchId_ = stagingRing.getLastBatchId();
+    commandBuffer_ = VK_NULL_HANDLE;
+    stagedSize_ = 0;
+    commandCount_ = 0;
+}
+
+void UploadBatch::submit()
+{
+    flush();
+
+    if(lastBatchId_ != 0)
+    {
+        pCore_->getStagingRing().waitForBatch(lastBatchId_);
+        lastBatchId_ = 0;
+    }
+}
+
+uint64_t UploadBatch::submitAsync()
+{
+    flush();
+
+    uint64_t batchId = lastBatchId_;
+    lastBatchId_ = 0;
+    return batchId;
+}
+
+void* UploadBatch::stage(VkDeviceSize size, VkBuffer& stagingBuffer, VkDeviceSize& stagingOffset)
+{
+    StagingRing& stagingRing = pCore_->getStagingRing();
+
+    //The ring would otherwise grow to the size of everything recorded
+    if(commandCount_ > 0 && stagedSize_ + size > stagingRing.getCapacity() / 2)
+    {
+        flush();
+    }
+
+    StagingRange range = stagingRing.allocate(size);
+    stagingBuffer = range.buffer;
+    stagingOffset = range.offset;
+    stagedSize_ += size;
+    return range.pMapped;
+}
+
+void* UploadBatch::stageBufferCopy(VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+    VkBuffer stagingBuffer;
+    VkBufferCopy copyRegion = {};
+    //Staged first, the ring may start a new command buffer
+    void* pData = stage(size, stagingBuffer, copyRegion.srcOffset);
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+
+    vkCmdCopyBuffer(getCommandBuffer(), stagingBuffer, dstBuffer, 1, &copyRegion);
+
+    if(releasesBuffers_)
+    {
+        releaseBarriers_.push_back(createTransferBarrier(pCore_, dstBuffer, 0));
+    }
+
+    return pData;
+}
+
+void UploadBatch::copyToBuffer(const void* pData, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+    memcpy(stageBufferCopy(size, dstBuffer, dstOffset), pData, size);
+}
+
+void UploadBatch::copyToImage(const void* pPixels, VkImage image, uint32_t width, uint32_t height)
+{
+    VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+    VkBuffer stagingBuffer;
+    VkBufferImageCopy region = {};
+    memcpy(stage(size, stagingBuffer, region.bufferOffset), pPixels, size);
+
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { width, height, 1 };
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    vkCmdCopyBufferToImage(getCommandBuffer(), stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                           &region);
+}
+
+void UploadBatch::pipelineBarrier(VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+                                  const VkImageMemoryBarrier& barrier)
+{
+    vkCmdPipelineBarrier(getCommandBuffer(), srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void UploadBatch::acquireBuffer(VkBuffer buffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkBufferMemoryBarrier barrier = createTransferBarrier(pCore_, buffer, dstAccess);
+    vkCmdPipelineBarrier(getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 1, &barrier,
+                         0, nullptr);
+}
+
+}
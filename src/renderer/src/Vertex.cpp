@@ -37,4 +37,37 @@ std::array<VkVertexInputAttributeDescription, 3> Vertex::getAttributeDescription
     return attribDescriptions;
 }
 
+VkVertexInputBindingDescription CompactVertex::getBindingDescription()
+{
+    VkVertexInputBindingDescription bindingDescription = {};
+
+    bindingDescription.binding = 0;
+    bindingDescription.stride = sizeof(CompactVertex);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return bindingDescription;
+}
+
+std::array<VkVertexInputAttributeDescription, 3> CompactVertex::getAttributeDescriptions()
+{
+    //The normalized formats are converted to floats in [0, 1] or [-1, 1] by the vertex fetch
+    std::array<VkVertexInputAttributeDescription, 3> attribDescriptions = {};
+    attribDescriptions[0].binding = 0;
+    attribDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+    attribDescriptions[0].location = 0;
+    attribDescriptions[0].offset = offsetof(data::CompactVertexAttribute, pos);
+
+    attribDescriptions[1].binding = 0;
+    attribDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+    attribDescriptions[1].location = 1;
+    attribDescriptions[1].offset = offsetof(data::CompactVertexAttribute, normal);
+
+    attribDescriptions[2].binding = 0;
+    attribDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+    attribDescriptions[2].location = 2;
+    attribDescriptions[2].offset = offsetof(data::CompactVertexAttribute, texCoord);
+
+    return attribDescriptions;
+}
+
 }
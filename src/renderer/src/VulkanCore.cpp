@@ -4,9 +4,11 @@
 #include <array>
 #include <fstream>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include "loader/ObjLoader.h"
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/matrix.hpp>
 
 namespace renderer
 {
@@ -15,8 +17,8 @@ VulkanCore::VulkanCore():
     debugMessenger_(this, &instance_),
     swapchain_(this),
     utilities_(this),
-    lenaTexture_(this, std::string(RESOURCE_PATH) + "/textures/default.bmp", VK_FORMAT_R8G8B8A8_UNORM),
-    model_(this)
+    pStagingRing_(new StagingRing(this)),
+    textureCache_(this)
 {
     if(ENABLE_VALIDATION_LAYERS)
     {
@@ -26,13 +28,15 @@ VulkanCore::VulkanCore():
 
 void VulkanCore::drawFrame()
 {
+    updateModelUploads();
+    selectModelLods();
     checkApplicationState();
 
     uint32_t imageIndex;
 
+    //Reset just before the submission, the fence stays signaled if the frame is not submitted
     vkWaitForFences(logicalDevice_, 1, &inFlightFences_[currentFrame_], VK_TRUE,
                     std::numeric_limits<uint64_t>::max());
-    vkResetFences(logicalDevice_, 1, &inFlightFences_[currentFrame_]);
     //Timeout in nanoseconds = numeric_limits... using the max disable the timeout
     VkResult result = vkAcquireNextImageKHR(logicalDevice_, swapchain_.getVkSwapchain(),
                                             std::numeric_limits<uint64_t>::max(), imageAvailableSemaphore_[currentFrame_], VK_NULL_HANDLE,
@@ -48,8 +52,23 @@ void VulkanCore::drawFrame()
         throw std::runtime_error("failed to acquire swap chain image!");
     }
 
+    //The images are not acquired in order : the last frame rendered to this one may still read its uniform slot
+    if(imagesInFlight_[imageIndex] != VK_NULL_HANDLE)
+    {
+        vkWaitForFences(logicalDevice_, 1, &imagesInFlight_[imageIndex], VK_TRUE,
+                        std::numeric_limits<uint64_t>::max());
+    }
+
+    imagesInFlight_[imageIndex] = inFlightFences_[currentFrame_];
     updateUniformBuffer(imageIndex);
 
+    //Only the command buffer of the image, no frame uses it anymore after the wait
+    if(outdatedCommandBuffers_[imageIndex])
+    {
+        recordCommandBuffer(imageIndex);
+        outdatedCommandBuffers_[imageIndex] = false;
+    }
+
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.waitSemaphoreCount = 1;
@@ -67,7 +86,8 @@ void VulkanCore::drawFrame()
 
     vkResetFences(logicalDevice_, 1, &inFlightFences_[currentFrame_]);
 
-    if(vkQueueSubmit(presentQueue_, 1, &submitInfo, inFlightFences_[currentFrame_]) != VK_SUCCESS)
+    //After the acquisitions of the uploaded buffers, on the same queue
+    if(vkQueueSubmit(graphicsQueue_, 1, &submitInfo, inFlightFences_[currentFrame_]) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
@@ -113,20 +133,20 @@ void VulkanCore::initVulkan()
 {
     pickPhysicalDevice();
     createLogicalDevice();
+    utilities_.createAllocator();
     createSwapChain();
     createRenderPass();
     createDescriptorSetLayout();
     createGraphicsPipeline();
     createCommandPool();
+    pStagingRing_->create();
     createDepthRessources();
     createColorRessources();
     swapchain_.createFramebuffers(renderPass_, {colorImageView_, depthImageView_});
-    lenaTexture_.create();
-//  createVertexBuffer();
-//  createVertexIndexBuffer();
     createUniformBuffer();
     createDescriptorPool();
     createDescriptorSets();
+    createDefaultMaterial();
     createCommandBuffers();
     createSyncObjects();
 
@@ -211,6 +231,26 @@ const VulkanUtils& VulkanCore::getUtils() const
     return utilities_;
 }
 
+StagingRing& VulkanCore::getStagingRing() const
+{
+    return *pStagingRing_;
+}
+
+const VkDescriptorSetLayout& VulkanCore::getMaterialSetLayout() const
+{
+    return materialSetLayout_;
+}
+
+const VkDescriptorPool& VulkanCore::getMaterialDescriptorPool() const
+{
+    return materialDescriptorPool_;
+}
+
+TextureCache& VulkanCore::getTextureCache()
+{
+    return textureCache_;
+}
+
 void VulkanCore::createInstance()
 {
     isCleaned_ = false;
@@ -286,12 +326,94 @@ void VulkanCore::setCamera(const Camera& camera)
     camera_ = camera;
 }
 
-void VulkanCore::setModel(const Model& model)
+void VulkanCore::setModel(Model* pModel)
 {
     applicationChanges_.modelModified = true;
-    model_.destroy();
-    model_ = model;
-    model_.create();
+
+    if(pModel_)
+    {
+        //Only on a change of model, the frames in flight may still draw its buffers
+        vkQueueWaitIdle(graphicsQueue_);
+        pModel_->destroy();
+    }
+
+    pModel_ = pModel;
+
+    if(!pModel_)
+    {
+        return;
+    }
+
+    pModel_->create();
+
+    for(size_t idxMesh = 0; idxMesh < pModel_->getMeshData().size(); idxMesh++)
+    {
+        pModel_->setMaterialForMesh(idxMesh, findMaterial(pModel_->getMeshInfos()[idxMesh].material));
+    }
+}
+
+void VulkanCore::appendMeshesToModel(const std::vector<data::MeshPtr>& meshes)
+{
+    //Drawn once their upload completes, see updateModelUploads
+    size_t firstMesh = pModel_->getMeshData().size();
+    pModel_->appendMeshes(meshes);
+
+    for(size_t idxMesh = 0; idxMesh < meshes.size(); idxMesh++)
+    {
+        pModel_->setMaterialForMesh(firstMesh + idxMesh, findMaterial(meshes[idxMesh]->material));
+    }
+}
+
+void VulkanCore::createDefaultMaterial()
+{
+    std::shared_ptr<MaterialTexture> pTexture = textureCache_.getTexture(std::string(RESOURCE_PATH) +
+            "/textures/default.bmp");
+
+    if(!pTexture)
+    {
+        throw std::runtime_error("failed to load texture image!");
+    }
+
+    pDefaultMaterial_.reset(new Material(this, "default", glm::vec3(1.0f), pTexture));
+    pDefaultMaterial_->create();
+}
+
+const Material& VulkanCore::findMaterial(const data::MaterialData& materialData)
+{
+    if(materialData.name.empty() && materialData.diffuseTexture.empty())
+    {
+        return *pDefaultMaterial_;
+    }
+
+    //Materials of different files may have the same name, they are told apart by their content
+    std::string key = materialData.name + '\n' + materialData.diffuseTexture + '\n' +
+                      std::to_string(materialData.diffuseColor.r) + ' ' + std::to_string(materialData.diffuseColor.g) +
+                      ' ' + std::to_string(materialData.diffuseColor.b);
+    auto itMaterial = materials_.find(key);
+
+    if(itMaterial != materials_.end())
+    {
+        return *itMaterial->second;
+    }
+
+    if(materials_.size() >= MAX_MATERIAL_COUNT)
+    {
+        PLOGW << "Too many materials, " << materialData.name << " is replaced by the default material" << '\n';
+        return *pDefaultMaterial_;
+    }
+
+    //A texture that can't be read leaves the diffuse color alone
+    std::shared_ptr<MaterialTexture> pTexture = textureCache_.getTexture(materialData.diffuseTexture);
+
+    if(!pTexture)
+    {
+        pTexture = textureCache_.getWhiteTexture();
+    }
+
+    std::unique_ptr<Material> pMaterial(new Material(this, materialData.name, materialData.diffuseColor, pTexture));
+    pMaterial->create();
+
+    return *(materials_[key] = std::move(pMaterial));
 }
 
 VkResult VulkanCore::areInstanceExtensionsCompatible(const char** extensions,
@@ -509,31 +631,47 @@ void VulkanCore::createRenderPass()
 void VulkanCore::createDescriptorSetLayout()
 {
     PLOGD << "Creating Descriptor Set Layout..." << '\n';
-    VkDescriptorSetLayoutBinding uboLayoutBinding = {};
-    uboLayoutBinding.binding = 0; //Value in shader "layout(binding = 0) uniform"
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboLayoutBinding.descriptorCount = 1; //Number of object to pass
-    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    uboLayoutBinding.pImmutableSamplers = nullptr;
+    std::array<VkDescriptorSetLayoutBinding, 2> frameLayoutBindings = {};
+    //Camera data
+    frameLayoutBindings[0].binding = 0; //Value in shader "layout(binding = 0) uniform"
+    //The offset of the slot is given when the set is bound
+    frameLayoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    frameLayoutBindings[0].descriptorCount = 1; //Number of object to pass
+    frameLayoutBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    frameLayoutBindings[0].pImmutableSamplers = nullptr;
+    //Object data, in the same slot
+    frameLayoutBindings[1].binding = 1;
+    frameLayoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    frameLayoutBindings[1].descriptorCount = 1;
+    frameLayoutBindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    frameLayoutBindings[1].pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(frameLayoutBindings.size());
+    layoutInfo.pBindings = frameLayoutBindings.data();
+
+    if(vkCreateDescriptorSetLayout(logicalDevice_, &layoutInfo, nullptr,
+                                   &descriptorSetLayout_) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
 
+    //The texture is bound per material, in a set of its own
     VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
-    samplerLayoutBinding.binding = 1;
+    samplerLayoutBinding.binding = 0;
     samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     samplerLayoutBinding.descriptorCount = 1; //Number of object to pass
     samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
     samplerLayoutBinding.pImmutableSamplers = nullptr;
 
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-
-    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-    layoutInfo.pBindings = bindings.data();
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &samplerLayoutBinding;
 
     if(vkCreateDescriptorSetLayout(logicalDevice_, &layoutInfo, nullptr,
-                                   &descriptorSetLayout_) != VK_SUCCESS)
+                                   &materialSetLayout_) != VK_SUCCESS)
     {
-        throw std::runtime_error("failed to create descriptor set layout!");
+        throw std::runtime_error("failed to create material descriptor set layout!");
     }
 
     PLOGD << "Descriptor Set Layout Created" << '\n';
@@ -543,9 +681,11 @@ void VulkanCore::createGraphicsPipeline()
 {
     PLOGD << "Creating Graphics Pipeline..." << '\n';
     auto vertexShader = readFile(std::string(RESOURCE_PATH) + "/shaders/vert.spv");
+    auto compactVertexShader = readFile(std::string(RESOURCE_PATH) + "/shaders/compactVert.spv");
     auto fragmentShader = readFile(std::string(RESOURCE_PATH) + "/shaders/frag.spv");
 
     VkShaderModule vertexShaderModule = createShaderModule(vertexShader);
+    VkShaderModule compactVertexShaderModule = createShaderModule(compactVertexShader);
     VkShaderModule fragmentShaderModule = createShaderModule(fragmentShader);
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
@@ -655,10 +795,20 @@ void VulkanCore::createGraphicsPipeline()
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout_;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+    std::array<VkDescriptorSetLayout, 2> setLayouts = { descriptorSetLayout_, materialSetLayout_ };
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    //Both pipelines share the layout, the standard vertex shader ignores the quantization constants
+    std::array<VkPushConstantRange, 2> pushConstantRanges = {};
+    pushConstantRanges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRanges[0].offset = 0;
+    pushConstantRanges[0].size = sizeof(QuantizationConstants);
+    pushConstantRanges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRanges[1].offset = sizeof(QuantizationConstants);
+    pushConstantRanges[1].size = sizeof(MaterialConstants);
+
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 
     if(vkCreatePipelineLayout(logicalDevice_, &pipelineLayoutInfo, nullptr,
                               &pipelineLayout_) != VK_SUCCESS)
@@ -692,7 +842,57 @@ void VulkanCore::createGraphicsPipeline()
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
+    auto compactBindingDescription = CompactVertex::getBindingDescription();
+    auto compactAttributeDescriptions = CompactVertex::getAttributeDescriptions();
+    vertexInputInfo.pVertexAttributeDescriptions = compactAttributeDescriptions.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>
+            (compactAttributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = &compactBindingDescription;
+    shaderStageInfos[0].module = compactVertexShaderModule;
+
+    if(vkCreateGraphicsPipelines(logicalDevice_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+                                 &compactPipeline_) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create compact vertex graphics pipeline!");
+    }
+
+    //A point has no face to cull, nor a normal to be lit with
+    assemblyInfos.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    rasterizerInfo.cullMode = VK_CULL_MODE_NONE;
+
+    VkBool32 unlit = VK_TRUE;
+    VkSpecializationMapEntry unlitEntry = {};
+    unlitEntry.constantID = 0;
+    unlitEntry.offset = 0;
+    unlitEntry.size = sizeof(VkBool32);
+
+    VkSpecializationInfo unlitInfo = {};
+    unlitInfo.mapEntryCount = 1;
+    unlitInfo.pMapEntries = &unlitEntry;
+    unlitInfo.dataSize = sizeof(VkBool32);
+    unlitInfo.pData = &unlit;
+    shaderStageInfos[1].pSpecializationInfo = &unlitInfo;
+
+    if(vkCreateGraphicsPipelines(logicalDevice_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+                                 &compactPointPipeline_) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create compact vertex point pipeline!");
+    }
+
+    vertexInputInfo.pVertexAttributeDescriptions = vertexAttributeDescriptions.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>
+            (vertexAttributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = &vertexBindingDescription;
+    shaderStageInfos[0].module = vertexShaderModule;
+
+    if(vkCreateGraphicsPipelines(logicalDevice_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+                                 &pointPipeline_) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create point pipeline!");
+    }
+
     vkDestroyShaderModule(logicalDevice_, vertexShaderModule, nullptr);
+    vkDestroyShaderModule(logicalDevice_, compactVertexShaderModule, nullptr);
     vkDestroyShaderModule(logicalDevice_, fragmentShaderModule, nullptr);
 
     PLOGD << "Graphics Pipeline Created" << '\n';
@@ -707,6 +907,8 @@ void VulkanCore::createCommandPool()
     VkCommandPoolCreateInfo commandPoolInfo = {};
     commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     commandPoolInfo.queueFamilyIndex = indices.graphicsFamily;
+    //The command buffer of an image is recorded again on its own when the model changes
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
     if(vkCreateCommandPool(logicalDevice_, &commandPoolInfo, nullptr, &commandPool_) != VK_SUCCESS)
     {
@@ -716,6 +918,7 @@ void VulkanCore::createCommandPool()
     if(indices.transferAvailable())
     {
         commandPoolInfo.queueFamilyIndex = indices.transferFamily;
+        commandPoolInfo.flags = 0;
 
         if(vkCreateCommandPool(logicalDevice_, &commandPoolInfo, nullptr,
                                &commandPoolTransfert_) != VK_SUCCESS)
@@ -755,106 +958,41 @@ void VulkanCore::createColorRessources()
                                      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1);
 }
 
-void VulkanCore::recreateCommandBuffer()
-{
-    vkDeviceWaitIdle(logicalDevice_);
-    vkFreeCommandBuffers(logicalDevice_, commandPool_, (uint32_t)commandBuffers_.size(),
-                         commandBuffers_.data());
-    createCommandBuffers();
-}
-
-void VulkanCore::createVertexBuffer()
+void VulkanCore::outdateCommandBuffers()
 {
-    PLOGD << "Creating and Allocating Vertex Buffer" << '\n';
-    VkDeviceSize bufferSize = sizeof(meshes_[0].vertices[0]) * meshes_[0].vertices.size();
-    VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-
-    utilities_.createBuffer(bufferSize, usage, properties, stagingBuffer, stagingBufferMemory);
-
-    void* pData;//Contains a pointer to the mapped memory
-
-    //Documentation : memory must have been created with a memory type that reports VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-    //                  flags is reserved for future use of the vulkanAPI.
-    vkMapMemory(logicalDevice_, stagingBufferMemory, 0, bufferSize, 0, &pData);
-    memcpy(pData, meshes_[0].vertices.data(), (size_t)bufferSize);
-    vkUnmapMemory(logicalDevice_, stagingBufferMemory);
-
-    utilities_.createBuffer(bufferSize,
-                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer_, vertexBufferMemory_);
-    utilities_.copyBuffer(stagingBuffer, vertexBuffer_, bufferSize);
-
-    vkDestroyBuffer(logicalDevice_, stagingBuffer, nullptr);
-    vkFreeMemory(logicalDevice_, stagingBufferMemory, nullptr);
-    PLOGD << "Vertex Buffer Created" << '\n';
-}
-
-void VulkanCore::createVertexIndexBuffer()
-{
-
-    PLOGD << "Creating and Allocating Index Buffer" << '\n';
-    VkDeviceSize bufferSize = sizeof(meshes_[0].indices[0]) * meshes_[0].indices.size();
-    VkBufferUsageFlags usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-
-    utilities_.createBuffer(bufferSize, usage, properties, stagingBuffer, stagingBufferMemory);
-
-    void* pData;//Contains a pointer to the mapped memory
-
-    //Documentation : memory must have been created with a memory type that reports VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-    //                  flags is reserved for future use of the vulkanAPI.
-    vkMapMemory(logicalDevice_, stagingBufferMemory, 0, bufferSize, 0, &pData);
-    memcpy(pData, meshes_[0].indices.data(), (size_t)bufferSize);
-    vkUnmapMemory(logicalDevice_, stagingBufferMemory);
-
-    utilities_.createBuffer(bufferSize,
-                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexIndexBuffer_, vertexIndexBufferMemory_);
-    utilities_.copyBuffer(stagingBuffer, vertexIndexBuffer_, bufferSize);
-
-    vkDestroyBuffer(logicalDevice_, stagingBuffer, nullptr);
-    vkFreeMemory(logicalDevice_, stagingBufferMemory, nullptr);
-    PLOGD << "Index Buffer Created" << '\n';
+    //Recorded by drawFrame when their image is acquired, the queue is never idled for it
+    outdatedCommandBuffers_.assign(commandBuffers_.size(), true);
 }
 
 void VulkanCore::createUniformBuffer()
 {
     PLOGD << "Creating Uniform Buffer..." << '\n';
-    VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-    uniformBuffers_.resize(swapchain_.getImageViews().size());
-    uniformBuffersMemory_.resize(swapchain_.getImageViews().size());
-
-    for(size_t i = 0; i < swapchain_.getImageViews().size(); i++)
-    {
-        utilities_.createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                uniformBuffers_[i], uniformBuffersMemory_[i]);
-    }
+    const VkPhysicalDeviceLimits& limits = physicalDeviceProperties_.getVkPhysicalDeviceProperties().limits;
+    //Both are powers of two, the larger one is a multiple of the other
+    VkDeviceSize alignment = std::max(limits.minUniformBufferOffsetAlignment,
+                                      limits.minStorageBufferOffsetAlignment);
+    objectDataOffset_ = (sizeof(CameraData) + alignment - 1) / alignment * alignment;
+    uniformSlotSize_ = objectDataOffset_ + MAX_OBJECT_COUNT * sizeof(ObjectData);
+    uniformSlotSize_ = (uniformSlotSize_ + alignment - 1) / alignment * alignment;
+
+    utilities_.createBuffer(uniformSlotSize_ * swapchain_.getImageViews().size(),
+                            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            uniformBuffer_, uniformBufferMemory_);
 
     PLOGD << "Uniform Buffer Created" << '\n';
 }
 
 void VulkanCore::updateUniformBuffer(uint32_t imageIndex)
 {
-    uint16_t angle = 0;
-
-    UniformBufferObject ubo = {};
+    CameraData cameraData = {};
 
-    ubo.model = glm::mat4x4(1.0f);
-    ubo.view = glm::mat4x4(1.0f);
+    cameraData.view = glm::lookAt(camera_.getPosition(), camera_.getCenter(), camera_.getUp());
 
-    ubo.view = glm::lookAt(camera_.getPosition(), camera_.getCenter(), camera_.getUp());
-
-    ubo.projection = glm::perspective(camera_.getFov(),
-                                      swapchain_.getExtent().width / (float)swapchain_.getExtent().height, 0.01f, 100.0f);
+    cameraData.projection = glm::perspective(camera_.getFov(),
+                                             swapchain_.getExtent().width / (float)swapchain_.getExtent().height, 0.01f, 100.0f);
+    cameraData.inverseView = glm::inverse(cameraData.view);
+    cameraData.eyePosition = cameraData.inverseView[3];
 
     static auto startTime = std::chrono::high_resolution_clock::now();
 
@@ -862,15 +1000,21 @@ void VulkanCore::updateUniformBuffer(uint32_t imageIndex)
     float time = 2 * std::chrono::duration<float, std::chrono::seconds::period>
                  (currentTime - startTime).count();
 
-    ubo.lightPos = glm::vec3(4 * cos(time), 4 * sin(time), 3);
+    cameraData.lightPosition = glm::vec4(4 * cos(time), 4 * sin(time), 3, 1.0f);
 
-    void* pData;
+    //Only the slot read by the image, drawFrame waited for the last frame rendered to it
+    char* pSlot = static_cast<char*>(uniformBufferMemory_.pMapped) + imageIndex * uniformSlotSize_;
+    memcpy(pSlot, &cameraData, sizeof(CameraData));
 
-    for(uint8_t i = 0; i < swapchain_.getImageViews().size(); i++)
+    if(pModel_)
     {
-        vkMapMemory(logicalDevice_, uniformBuffersMemory_[i], 0, sizeof(UniformBufferObject), 0, &pData);
-        memcpy(pData, &ubo, sizeof(UniformBufferObject));
-        vkUnmapMemory(logicalDevice_, uniformBuffersMemory_[i]);
+        //The inverses are computed here once rather than for each vertex. The model is drawn where it was loaded
+        ObjectData objectData;
+        objectData.model = glm::mat4x4(1.0f);
+        objectData.normal = glm::mat4x4(glm::transpose(glm::inverse(glm::mat3x3(objectData.model))));
+        objectData.mvp = cameraData.projection * cameraData.view * objectData.model;
+        memcpy(pSlot + objectDataOffset_ + MODEL_OBJECT_INDEX * sizeof(ObjectData), &objectData,
+               sizeof(ObjectData));
     }
 }
 
@@ -878,79 +1022,80 @@ void VulkanCore::createDescriptorPool()
 {
     PLOGD << "Creating Descriptor Pool..." << '\n';
 
+    //Camera and object data, a single set for every swapchain image
     std::array<VkDescriptorPoolSize, 2> descPoolSizes = {};
-    //UBO
-    descPoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    descPoolSizes[0].descriptorCount = static_cast<uint32_t>(swapchain_.getImages().size());
-
-    //Textures
-    descPoolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descPoolSizes[1].descriptorCount = static_cast<uint32_t>(swapchain_.getImages().size());
-
+    descPoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descPoolSizes[0].descriptorCount = 1;
+    descPoolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    descPoolSizes[1].descriptorCount = 1;
 
     VkDescriptorPoolCreateInfo descPoolInfo = {};
     descPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     descPoolInfo.poolSizeCount = static_cast<uint32_t>(descPoolSizes.size());
     descPoolInfo.pPoolSizes = descPoolSizes.data();
-    descPoolInfo.maxSets = static_cast<uint32_t>(swapchain_.getImages().size());
+    descPoolInfo.maxSets = 1;
 
     if(vkCreateDescriptorPool(logicalDevice_, &descPoolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create descriptor pool!");
     }
 
+    //Textures, a set per material, freed with the material
+    VkDescriptorPoolSize descPoolSize = {};
+    descPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descPoolSize.descriptorCount = MAX_MATERIAL_COUNT + 1;
+    descPoolInfo.poolSizeCount = 1;
+    descPoolInfo.pPoolSizes = &descPoolSize;
+    descPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    descPoolInfo.maxSets = MAX_MATERIAL_COUNT + 1;
+
+    if(vkCreateDescriptorPool(logicalDevice_, &descPoolInfo, nullptr, &materialDescriptorPool_) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create material descriptor pool!");
+    }
+
     PLOGD << "Descriptor Pool Created" << '\n';
 }
 
 void VulkanCore::createDescriptorSets()
 {
     PLOGD << "Creating Descriptor Sets..." << '\n';
-    std::vector<VkDescriptorSetLayout> layouts(swapchain_.getImages().size(), descriptorSetLayout_);
     VkDescriptorSetAllocateInfo descAlloc = {};
     descAlloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     descAlloc.descriptorPool = descriptorPool_;
-    descAlloc.descriptorSetCount = static_cast<uint32_t>(swapchain_.getImages().size());
-    descAlloc.pSetLayouts = layouts.data();
-
-    descriptorSets_.resize(swapchain_.getImages().size());
+    descAlloc.descriptorSetCount = 1;
+    descAlloc.pSetLayouts = &descriptorSetLayout_;
 
-    if(vkAllocateDescriptorSets(logicalDevice_, &descAlloc, descriptorSets_.data()) != VK_SUCCESS)
+    if(vkAllocateDescriptorSets(logicalDevice_, &descAlloc, &descriptorSet_) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to allocate descriptor sets!");
     }
 
-    for(size_t i = 0; i < swapchain_.getImages().size(); i++)
-    {
-        VkDescriptorBufferInfo descBufferInfo = {};
-        descBufferInfo.buffer = uniformBuffers_[i];
-        descBufferInfo.offset = 0;
-        descBufferInfo.range = sizeof(UniformBufferObject);
-
-        VkDescriptorImageInfo imageInfo = {};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = lenaTexture_.getImageView();
-        imageInfo.sampler = lenaTexture_.getSampler();
-
-        std::array<VkWriteDescriptorSet, 2> writeInfos = {};
-        writeInfos[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writeInfos[0].dstSet = descriptorSets_[i];
-        writeInfos[0].dstBinding = 0; //binding index in "layout(binding = 0)"
-        writeInfos[0].dstArrayElement = 0;
-        writeInfos[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        writeInfos[0].descriptorCount = 1; //We can update multiple descriptor at once in an array
-        writeInfos[0].pBufferInfo = &descBufferInfo;
-
-        writeInfos[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writeInfos[1].dstSet = descriptorSets_[i];
-        writeInfos[1].dstBinding = 1; //binding index in "layout(binding = 0)"
-        writeInfos[1].dstArrayElement = 0;
-        writeInfos[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        writeInfos[1].descriptorCount = 1; //We can update multiple descriptor at once in an array
-        writeInfos[1].pImageInfo = &imageInfo;
-
-        vkUpdateDescriptorSets(logicalDevice_, static_cast<uint32_t>(writeInfos.size()), writeInfos.data(),
-                               0, nullptr);
-    }
+    //The parts of the first slot, the offset of the slot is dynamic
+    std::array<VkDescriptorBufferInfo, 2> descBufferInfos = {};
+    descBufferInfos[0].buffer = uniformBuffer_;
+    descBufferInfos[0].offset = 0;
+    descBufferInfos[0].range = sizeof(CameraData);
+    descBufferInfos[1].buffer = uniformBuffer_;
+    descBufferInfos[1].offset = objectDataOffset_;
+    descBufferInfos[1].range = MAX_OBJECT_COUNT * sizeof(ObjectData);
+
+    //The textures are in the sets of the materials
+    std::array<VkWriteDescriptorSet, 2> writeInfos = {};
+    writeInfos[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeInfos[0].dstSet = descriptorSet_;
+    writeInfos[0].dstBinding = 0; //binding index in "layout(binding = 0)"
+    writeInfos[0].dstArrayElement = 0;
+    writeInfos[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    writeInfos[0].descriptorCount = 1; //We can update multiple descriptor at once in an array
+    writeInfos[0].pBufferInfo = &descBufferInfos[0];
+    writeInfos[1] = writeInfos[0];
+    writeInfos[1].dstBinding = 1;
+    writeInfos[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    writeInfos[1].pBufferInfo = &descBufferInfos[1];
+
+    vkUpdateDescriptorSets(logicalDevice_, static_cast<uint32_t>(writeInfos.size()), writeInfos.data(), 0,
+                           nullptr);
 
     PLOGD << "Descriptor Sets Created" << '\n';
 }
@@ -977,64 +1122,144 @@ void VulkanCore::createCommandBuffers()
         throw std::runtime_error("failed to create command buffers!");
     }
 
-    //For every command buffer we begin recording it, but we have to specify how
     for(size_t i = 0; i < commandBuffers_.size(); i++)
     {
-        VkCommandBufferBeginInfo commandBeginInfo = {};
-        commandBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        commandBeginInfo.flags =
-            VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT; //We can resubmit the command buffer while it's already pending execution
-        commandBeginInfo.pInheritanceInfo = nullptr;
+        recordCommandBuffer(i);
+    }
+
+    outdatedCommandBuffers_.assign(commandBuffers_.size(), false);
+    PLOGD << "Command Buffers Created" << '\n';
+}
+
+void VulkanCore::recordCommandBuffer(size_t imageIndex)
+{
+    VkCommandBuffer commandBuffer = commandBuffers_[imageIndex];
+
+    //The pool resets the buffer, drawFrame only records it once the last frame using it is complete
+    VkCommandBufferBeginInfo commandBeginInfo = {};
+    commandBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBeginInfo.flags = 0;
+    commandBeginInfo.pInheritanceInfo = nullptr;
+
+    if(vkBeginCommandBuffer(commandBuffer, &commandBeginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    std::array<VkClearValue, 2> clearValues = {};
+    clearValues[0].color = { 1.0f, (153.0f / 255.0f), (51.0f / 255.0f), 1.0f };
+    clearValues[1].depthStencil = { 1.0, 0 };
+
+    VkRenderPassBeginInfo renderBeginInfo = {};
+    renderBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderBeginInfo.pClearValues = clearValues.data();
+    renderBeginInfo.renderPass = renderPass_;
+    renderBeginInfo.framebuffer = swapchain_.getFramebuffers()[imageIndex];
+    renderBeginInfo.renderArea.extent = swapchain_.getExtent();
+    renderBeginInfo.renderArea.offset = { 0, 0 };
+
+    vkCmdBeginRenderPass(commandBuffer, &renderBeginInfo,
+                         VK_SUBPASS_CONTENTS_INLINE); // Last parameter used to embedd the command for a primary command buffer or secondary
+
+    size_t meshCount = pModel_ ? pModel_->getMeshData().size() : 0;
+    //Only recorded when they change, the meshes sharing buffers are consecutive
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize boundIndexOffset = 0;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_UINT32;
+    const Material* pBoundMaterial = nullptr;
+
+    //Both bindings are in the slot of the image
+    std::array<uint32_t, 2> slotOffsets;
+    slotOffsets.fill(static_cast<uint32_t>(imageIndex * uniformSlotSize_));
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1,
+                            &descriptorSet_, static_cast<uint32_t>(slotOffsets.size()), slotOffsets.data());
+
+    for(uint32_t idxMesh = 0;  idxMesh < meshCount; idxMesh++)
+    {
+        const MeshData& meshData = pModel_->getMeshData()[idxMesh];
 
-        if(vkBeginCommandBuffer(commandBuffers_[i], &commandBeginInfo) != VK_SUCCESS)
+        //Recorded again once uploaded
+        if(!meshData.isUploaded)
         {
-            throw std::runtime_error("failed to begin recording command buffer!");
+            continue;
         }
 
-        std::array<VkClearValue, 2> clearValues = {};
-        clearValues[0].color = { 1.0f, (153.0f / 255.0f), (51.0f / 255.0f), 1.0f };
-        clearValues[1].depthStencil = { 1.0, 0 };
+        const MeshBuffers& meshBuffers = pModel_->getMeshBuffers()[meshData.buffersIndex];
+        VkPipeline pipeline;
 
-        VkRenderPassBeginInfo renderBeginInfo = {};
-        renderBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderBeginInfo.pClearValues = clearValues.data();
-        renderBeginInfo.renderPass = renderPass_;
-        renderBeginInfo.framebuffer = swapchain_.getFramebuffers()[i];
-        renderBeginInfo.renderArea.extent = swapchain_.getExtent();
-        renderBeginInfo.renderArea.offset = { 0, 0 };
-
-        vkCmdBeginRenderPass(commandBuffers_[i], &renderBeginInfo,
-                             VK_SUBPASS_CONTENTS_INLINE); // Last parameter used to embedd the command for a primary command buffer or secondary
+        if(pModel_->getVertexFormat() == COMPACT_VERTEX)
+        {
+            QuantizationConstants constants;
+            constants.offset = glm::vec4(meshData.quantizationBounds.offset, 0.0f);
+            constants.scale = glm::vec4(meshData.quantizationBounds.scale, 0.0f);
+            pipeline = meshData.isPointCloud ? compactPointPipeline_ : compactPipeline_;
+            vkCmdPushConstants(commandBuffer, pipelineLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                               sizeof(QuantizationConstants), &constants);
+        }
+        else
+        {
+            pipeline = meshData.isPointCloud ? pointPipeline_ : graphicsPipeline_;
+        }
 
-        for(uint32_t idxMesh = 0;  idxMesh < model_.getMeshes().size(); idxMesh++)
+        if(pipeline != boundPipeline)
         {
-            const MeshData& meshData = model_.getMeshData()[idxMesh];
-            const data::Mesh& mesh = model_.getMeshes()[idxMesh];
-            vkCmdBindPipeline(commandBuffers_[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            boundPipeline = pipeline;
+        }
 
-            VkBuffer vertexBuffers[] = { meshData.vertexBuffer };
-            VkDeviceSize offsets[] = { 0 };
-            vkCmdBindVertexBuffers(commandBuffers_[i], 0, 1, vertexBuffers, offsets);
+        if(meshBuffers.vertexBuffer != boundVertexBuffer)
+        {
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &meshBuffers.vertexBuffer, &offset);
+            boundVertexBuffer = meshBuffers.vertexBuffer;
+        }
 
-            vkCmdBindIndexBuffer(commandBuffers_[i], meshData.vertexIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-            vkCmdBindDescriptorSets(commandBuffers_[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1,
-                                    &descriptorSets_[i], 0, nullptr);
+        const Material& material = meshData.material ? *meshData.material : *pDefaultMaterial_;
 
-            //1 used for the instanced rendering could be higher i think for multiple instanced
-            vkCmdDrawIndexed(commandBuffers_[i], static_cast<uint32_t>(mesh.indices.size()), 1, 0, 0, 0);
+        //The push constants and the set 0 stay valid across the pipelines, they share their layout
+        if(&material != pBoundMaterial)
+        {
+            MaterialConstants materialConstants;
+            materialConstants.diffuseColor = glm::vec4(material.getDiffuseColor(), 1.0f);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 1, 1,
+                                    &material.getDescriptorSet(), 0, nullptr);
+            vkCmdPushConstants(commandBuffer, pipelineLayout_, VK_SHADER_STAGE_FRAGMENT_BIT,
+                               sizeof(QuantizationConstants), sizeof(MaterialConstants), &materialConstants);
+            pBoundMaterial = &material;
         }
 
-        vkCmdEndRenderPass(commandBuffers_[i]);
+        if(meshData.isPointCloud)
+        {
+            vkCmdDraw(commandBuffer, meshData.vertexCount, 1, meshData.vertexOffset, MODEL_OBJECT_INDEX);
+            continue;
+        }
 
-        if(vkEndCommandBuffer(commandBuffers_[i]) != VK_SUCCESS)
+        if(meshBuffers.indexBuffer != boundIndexBuffer || meshData.indexBufferOffset != boundIndexOffset ||
+                meshData.indexType != boundIndexType)
         {
-            throw std::runtime_error("failed to record command buffer!");
+            vkCmdBindIndexBuffer(commandBuffer, meshBuffers.indexBuffer, meshData.indexBufferOffset,
+                                 meshData.indexType);
+            boundIndexBuffer = meshBuffers.indexBuffer;
+            boundIndexOffset = meshData.indexBufferOffset;
+            boundIndexType = meshData.indexType;
         }
 
+        const LodRange& lod = meshData.lods[meshData.selectedLod];
+
+        //The first instance is the index of the object data of the model
+        vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, lod.firstIndex,
+                         static_cast<int32_t>(meshData.vertexOffset), MODEL_OBJECT_INDEX);
     }
 
-    PLOGD << "Command Buffers Created" << '\n';
+    vkCmdEndRenderPass(commandBuffer);
+
+    if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record command buffer!");
+    }
 }
 
 void VulkanCore::createSyncObjects()
@@ -1044,6 +1269,7 @@ void VulkanCore::createSyncObjects()
     imageAvailableSemaphore_.resize(MAX_FRAMES_IN_FLIGHT);
     renderFinishedSemaphore_.resize(MAX_FRAMES_IN_FLIGHT);
     inFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
+    imagesInFlight_.assign(swapchain_.getImages().size(), VK_NULL_HANDLE);
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1067,6 +1293,27 @@ void VulkanCore::createSyncObjects()
     PLOGD << "Synchronization Objects Created" << '\n';
 }
 
+void VulkanCore::updateModelUploads()
+{
+    //The meshes uploaded since the last frame are drawn from this one
+    if(pModel_ && pModel_->updateUploads())
+    {
+        applicationChanges_.modelModified = true;
+    }
+}
+
+void VulkanCore::selectModelLods()
+{
+    //Height in pixels of a unit seen at a distance of 1 with the projection of updateUniformBuffer
+    float pixelsPerUnit = swapchain_.getExtent().height / (2.0f * std::abs(std::tan(camera_.getFov() / 2.0f)));
+
+    //The command buffers are recorded with the selected ranges, they are outdated on change
+    if(pModel_ && pModel_->selectLods(camera_.getPosition(), pixelsPerUnit, LOD_PIXEL_ERROR))
+    {
+        applicationChanges_.modelModified = true;
+    }
+}
+
 void VulkanCore::checkApplicationState()
 {
     for(size_t idx = 0; idx < sizeof(ApplicationStateChange); idx += sizeof(bool))
@@ -1075,7 +1322,7 @@ void VulkanCore::checkApplicationState()
 
         if(state == &applicationChanges_.modelModified && *state)
         {
-            recreateCommandBuffer();
+            outdateCommandBuffers();
             *state = false;
             return;
         }
@@ -1158,6 +1405,8 @@ void VulkanCore::recreateSwapChain()
 
     cleanUpSwapChain();
     createSwapChain();
+    //Every frame is complete after the wait
+    imagesInFlight_.assign(swapchain_.getImages().size(), VK_NULL_HANDLE);
     createRenderPass();
     createGraphicsPipeline();
     createDepthRessources();
@@ -1174,14 +1423,15 @@ void VulkanCore::cleanUpSwapChain()
                          commandBuffers_.data());
 
     vkDestroyImageView(logicalDevice_, depthImageView_, nullptr);
-    vkDestroyImage(logicalDevice_, depthImage_, nullptr);
-    vkFreeMemory(logicalDevice_, depthImageMemory_, nullptr);
+    utilities_.destroyImage(depthImage_, depthImageMemory_);
 
     vkDestroyImageView(logicalDevice_, colorImageView_, nullptr);
-    vkDestroyImage(logicalDevice_, colorImage_, nullptr);
-    vkFreeMemory(logicalDevice_, colorMemory_, nullptr);
+    utilities_.destroyImage(colorImage_, colorMemory_);
 
     vkDestroyPipeline(logicalDevice_, graphicsPipeline_, nullptr);
+    vkDestroyPipeline(logicalDevice_, compactPipeline_, nullptr);
+    vkDestroyPipeline(logicalDevice_, pointPipeline_, nullptr);
+    vkDestroyPipeline(logicalDevice_, compactPointPipeline_, nullptr);
     vkDestroyPipelineLayout(logicalDevice_, pipelineLayout_, nullptr);
     vkDestroyRenderPass(logicalDevice_, renderPass_, nullptr);
     swapchain_.destroy();
@@ -1192,23 +1442,34 @@ void VulkanCore::cleanup()
     if(!isCleaned_)
     {
         isCleaned_ = true;
+        //The uploads are not waited for by their callers
+        vkDeviceWaitIdle(logicalDevice_);
         cleanUpSwapChain();
 
+        //Materials and their textures
+        for(auto& material : materials_)
+        {
+            material.second->destroy();
+        }
+
+        materials_.clear();
+        pDefaultMaterial_->destroy();
+        textureCache_.clear();
+
         //Descriptor Set/Pool
         vkDestroyDescriptorPool(logicalDevice_, descriptorPool_, nullptr);
         vkDestroyDescriptorSetLayout(logicalDevice_, descriptorSetLayout_, nullptr);
-
-        lenaTexture_.destroy();
+        vkDestroyDescriptorPool(logicalDevice_, materialDescriptorPool_, nullptr);
+        vkDestroyDescriptorSetLayout(logicalDevice_, materialSetLayout_, nullptr);
 
         //Vertex/Uniform/Index buffers
-        for(size_t i = 0; i < swapchain_.getImages().size(); i++)
+        utilities_.destroyBuffer(uniformBuffer_, uniformBufferMemory_);
+
+        if(pModel_)
         {
-            vkDestroyBuffer(logicalDevice_, uniformBuffers_[i], nullptr);
-            vkFreeMemory(logicalDevice_, uniformBuffersMemory_[i], nullptr);
+            pModel_->destroy();
         }
 
-        model_.destroy();
-
         //Semaphores
         for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
@@ -1217,6 +1478,9 @@ void VulkanCore::cleanup()
             vkDestroyFence(logicalDevice_, inFlightFences_[i], nullptr);
         }
 
+        //Frees the command buffers of the uploads
+        pStagingRing_->destroy();
+
         //Command Pool
         vkDestroyCommandPool(logicalDevice_, commandPool_, nullptr);
 
@@ -1225,6 +1489,8 @@ void VulkanCore::cleanup()
             vkDestroyCommandPool(logicalDevice_, commandPoolTransfert_, nullptr);
         }
 
+        //Every buffer and image is destroyed
+        utilities_.destroyAllocator();
         vkDestroyDevice(logicalDevice_, nullptr);
         vkDestroySurfaceKHR(instance_, surface_, nullptr);
 
@@ -5,7 +5,8 @@ namespace renderer
 {
 
 VulkanUtils::VulkanUtils(const VulkanCore* pCore):
-    pCore_(pCore)
+    pCore_(pCore),
+    pAllocator_(new MemoryAllocator(pCore))
 {
 }
 
@@ -13,6 +14,21 @@ VulkanUtils::~VulkanUtils()
 {
 }
 
+void VulkanUtils::createAllocator()
+{
+    pAllocator_->create();
+}
+
+void VulkanUtils::destroyAllocator()
+{
+    pAllocator_->destroy();
+}
+
+MemoryAllocator& VulkanUtils::getAllocator() const
+{
+    return *pAllocator_;
+}
+
 VkImageView VulkanUtils::createImageView(VkFormat format, VkImage image,
         VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkImageViewCreateFlags flags)const
 {
@@ -39,7 +55,8 @@ VkImageView VulkanUtils::createImageView(VkFormat format, VkImage image,
 }
 
 void VulkanUtils::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
-                               VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)const
+                               VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferMemory,
+                               VkSharingMode sharingMode)const
 {
     //Create buffer
     VkBufferCreateInfo bufferInfo = {};
@@ -51,40 +68,32 @@ void VulkanUtils::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    if(indices.transferAvailable())
+    //A concurrent buffer needs two distinct families
+    if(sharingMode == VK_SHARING_MODE_CONCURRENT && indices.transferAvailable())
     {
         bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
         bufferInfo.pQueueFamilyIndices = sharingIndices;
         bufferInfo.queueFamilyIndexCount = 2;
     }
-    else
-    {
-        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
-        bufferInfo.pQueueFamilyIndices = &sharingIndices[0];
-        bufferInfo.queueFamilyIndexCount = 1;
-    }
 
     if(vkCreateBuffer(pCore_->getDevice(), &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create buffer!");
     }
 
-    //Allocate the memory on VRAM
+    //Sub-allocated from a block of the memory type
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(pCore_->getDevice(), buffer, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if(vkAllocateMemory(pCore_->getDevice(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
+    bufferMemory = pAllocator_->allocate(memRequirements, properties, false);
 
     //Bind the memory allocated with the vertex buffer
-    vkBindBufferMemory(pCore_->getDevice(), buffer, bufferMemory, 0);
+    vkBindBufferMemory(pCore_->getDevice(), buffer, bufferMemory.memory, bufferMemory.offset);
+}
+
+void VulkanUtils::destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory)const
+{
+    vkDestroyBuffer(pCore_->getDevice(), buffer, nullptr);
+    pAllocator_->free(bufferMemory);
 }
 
 VkCommandBuffer VulkanUtils::beginSingleTimeCommands(bool useTransfer)const
@@ -109,7 +118,7 @@ VkCommandBuffer VulkanUtils::beginSingleTimeCommands(bool useTransfer)const
     return commandBuffer;
 }
 
-void VulkanUtils::endSingleTimeCommands(VkCommandBuffer commandBuffer, bool useTransfer)const
+void VulkanUtils::endSingleTimeCommands(VkCommandBuffer commandBuffer, bool useTransfer, VkFence fence)const
 {
 
     VkCommandPool commandPool = useTransfer ? pCore_->getCommandPoolTransfer() :
@@ -123,25 +132,26 @@ void VulkanUtils::endSingleTimeCommands(VkCommandBuffer commandBuffer, bool useT
     subInfo.commandBufferCount = 1;
     subInfo.pCommandBuffers = &commandBuffer;
 
-    vkQueueSubmit(queue, 1, &subInfo, VK_NULL_HANDLE);
+    vkQueueSubmit(queue, 1, &subInfo, fence);
     vkQueueWaitIdle(queue);
 
     vkFreeCommandBuffers(pCore_->getDevice(), commandPool, 1, &commandBuffer);
 
 }
 
-void VulkanUtils::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)const
+void VulkanUtils::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
+                             VkDeviceSize srcOffset, VkFence fence)const
 {
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(true);
 
     VkBufferCopy copyRegion = {};
-    copyRegion.srcOffset = 0;
+    copyRegion.srcOffset = srcOffset;
     copyRegion.dstOffset = 0;
     copyRegion.size = size;
 
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-    endSingleTimeCommands(commandBuffer, true);
+    endSingleTimeCommands(commandBuffer, true, fence);
 }
 
 /*@brief : Check if the memory type of a device match the requirements in properties
@@ -165,7 +175,7 @@ uint32_t VulkanUtils::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags
 
 void VulkanUtils::createImage(uint32_t width, uint32_t height, uint32_t mipLevels,
                               VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-                              VkMemoryPropertyFlags property, VkImage& image, VkDeviceMemory& imageMemory,
+                              VkMemoryPropertyFlags property, VkImage& image, MemoryAllocation& imageMemory,
                               VkImageCreateFlags flags)const
 {
     VkImageCreateInfo imageInfo = {};
@@ -192,17 +202,15 @@ void VulkanUtils::createImage(uint32_t width, uint32_t height, uint32_t mipLevel
     VkMemoryRequirements imageMemoryRequirements = {};
     vkGetImageMemoryRequirements(pCore_->getDevice(), image, &imageMemoryRequirements);
 
-    VkMemoryAllocateInfo imageAllocInfo = {};
-    imageAllocInfo.allocationSize = imageMemoryRequirements.size;
-    imageAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    imageAllocInfo.memoryTypeIndex = findMemoryType(imageMemoryRequirements.memoryTypeBits, property);
+    imageMemory = pAllocator_->allocate(imageMemoryRequirements, property, tiling == VK_IMAGE_TILING_OPTIMAL);
 
-    if(vkAllocateMemory(pCore_->getDevice(), &imageAllocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to allocate image memory!");
-    }
+    vkBindImageMemory(pCore_->getDevice(), image, imageMemory.memory, imageMemory.offset);
+}
 
-    vkBindImageMemory(pCore_->getDevice(), image, imageMemory, 0);
+void VulkanUtils::destroyImage(VkImage image, MemoryAllocation& imageMemory)const
+{
+    vkDestroyImage(pCore_->getDevice(), image, nullptr);
+    pAllocator_->free(imageMemory);
 }
 
 void VulkanUtils::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout,
@@ -313,11 +321,11 @@ void VulkanUtils::transitionImageLayout(VkImage image, VkFormat format, VkImageL
 }
 
 void VulkanUtils::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
-                                    uint32_t height)const
+                                    uint32_t height, VkDeviceSize bufferOffset, VkFence fence)const
 {
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(true);
     VkBufferImageCopy region = {};
-    region.bufferOffset = 0;
+    region.bufferOffset = bufferOffset;
     region.bufferImageHeight = 0;
     region.bufferRowLength = 0;
     region.imageOffset = { 0, 0, 0 };
@@ -330,7 +338,7 @@ void VulkanUtils::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t wid
     vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
                            &region);
 
-    endSingleTimeCommands(commandBuffer, true);
+    endSingleTimeCommands(commandBuffer, true, fence);
 }
 
 VkSampleCountFlagBits VulkanUtils::getMaxUsableSampleCount()
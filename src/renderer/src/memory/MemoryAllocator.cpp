@@ -0,0 +1,357 @@
+#include "renderer/memory/MemoryAllocator.h"
+#include "renderer/VulkanCore.h"
+#include <algorithm>
+#include <plog/Log.h>
+
+namespace renderer
+{
+
+constexpr VkDeviceSize MemoryAllocator::MIN_NODE_SIZE;
+constexpr VkDeviceSize MemoryAllocator::MAX_BLOCK_SIZE;
+
+MemoryAllocator::MemoryAllocator(const VulkanCore* pCore):
+    VkElement(pCore)
+{
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+    if(isCreated_)
+    {
+        destroy();
+    }
+}
+
+void MemoryAllocator::create()
+{
+    const VkPhysicalDeviceMemoryProperties& memoryProperties =
+        pCore_->getPhysicalDeviceProperties().getVkPhysicalDeviceMemoryProperties();
+    const VkPhysicalDeviceLimits& limits =
+        pCore_->getPhysicalDeviceProperties().getVkPhysicalDeviceProperties().limits;
+
+    blockSizes_.resize(memoryProperties.memoryTypeCount);
+    stats_.assign(memoryProperties.memoryTypeCount, MemoryStats());
+
+    for(uint32_t idxType = 0; idxType < memoryProperties.memoryTypeCount; idxType++)
+    {
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[idxType].heapIndex].size;
+        VkDeviceSize blockSize = MAX_BLOCK_SIZE;
+
+        while(blockSize > MIN_NODE_SIZE && blockSize > heapSize / 8)
+        {
+            blockSize /= 2;
+        }
+
+        blockSizes_[idxType] = blockSize;
+    }
+
+    //The nodes are aligned on their size, a larger granularity could put a buffer and an image on a page
+    separateOptimalImages_ = limits.bufferImageGranularity > MIN_NODE_SIZE;
+
+    PLOGD << "Memory allocator created, bufferImageGranularity " << limits.bufferImageGranularity
+          << ", maxMemoryAllocationCount " << limits.maxMemoryAllocationCount << '\n';
+    isCreated_ = true;
+}
+
+void MemoryAllocator::destroy()
+{
+    if(!isCreated_)
+    {
+        return;
+    }
+
+    logStats();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for(const MemoryStats& stats : stats_)
+    {
+        if(stats.allocationCount > 0)
+        {
+            PLOGW << stats.allocationCount << " allocation(s) of " << stats.usedBytes
+                  << " bytes not freed before the destruction of the allocator" << '\n';
+        }
+    }
+
+    //Freeing a memory object unmaps it
+    for(const std::unique_ptr<MemoryBlock>& pBlock : blocks_)
+    {
+        vkFreeMemory(pCore_->getDevice(), pBlock->memory, nullptr);
+    }
+
+    blocks_.clear();
+    isCreated_ = false;
+}
+
+bool MemoryAllocator::isHostVisible(uint32_t memoryType) const
+{
+    const VkPhysicalDeviceMemoryProperties& memoryProperties =
+        pCore_->getPhysicalDeviceProperties().getVkPhysicalDeviceMemoryProperties();
+    return memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+MemoryBlock& MemoryAllocator::createBlock(uint32_t memoryType, bool isOptimalImage)
+{
+    std::unique_ptr<MemoryBlock> pBlock(new MemoryBlock());
+    pBlock->memoryType = memoryType;
+    pBlock->isOptimalImage = isOptimalImage;
+
+    while((MIN_NODE_SIZE << pBlock->maxOrder) < blockSizes_[memoryType])
+    {
+        pBlock->maxOrder++;
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = blockSizes_[memoryType];
+    allocInfo.memoryTypeIndex = memoryType;
+
+    if(vkAllocateMemory(pCore_->getDevice(), &allocInfo, nullptr, &pBlock->memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate a memory block!");
+    }
+
+    if(isHostVisible(memoryType))
+    {
+        void* pData;
+        vkMapMemory(pCore_->getDevice(), pBlock->memory, 0, VK_WHOLE_SIZE, 0, &pData);
+        pBlock->pMapped = static_cast<char*>(pData);
+    }
+
+    //The whole block is a free node
+    pBlock->freeNodes.resize(pBlock->maxOrder + 1);
+    pBlock->freeNodes[pBlock->maxOrder].insert(0);
+
+    stats_[memoryType].blockCount++;
+    stats_[memoryType].reservedBytes += blockSizes_[memoryType];
+    PLOGD << "Memory block of " << blockSizes_[memoryType] << " bytes created for memory type " << memoryType
+          << '\n';
+
+    blocks_.push_back(std::move(pBlock));
+    return *blocks_.back();
+}
+
+bool MemoryAllocator::allocateFromBlock(MemoryBlock& block, uint32_t order, MemoryAllocation& allocation)
+{
+    uint32_t freeOrder = order;
+
+    while(freeOrder <= block.maxOrder && block.freeNodes[freeOrder].empty())
+    {
+        freeOrder++;
+    }
+
+    if(freeOrder > block.maxOrder)
+    {
+        return false;
+    }
+
+    //Lowest offset first, the blocks fill from their beginning
+    VkDeviceSize offset = *block.freeNodes[freeOrder].begin();
+    block.freeNodes[freeOrder].erase(block.freeNodes[freeOrder].begin());
+
+    //The second half of each split node stays free
+    while(freeOrder > order)
+    {
+        freeOrder--;
+        block.freeNodes[freeOrder].insert(offset + (MIN_NODE_SIZE << freeOrder));
+    }
+
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.pMapped = block.pMapped ? block.pMapped + offset : nullptr;
+    allocation.pBlock = &block;
+    allocation.order = order;
+    block.allocationCount++;
+    return true;
+}
+
+MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags properties, bool isOptimalImage)
+{
+    MemoryAllocation allocation;
+    allocation.memoryType = pCore_->getUtils().findMemoryType(requirements.memoryTypeBits, properties);
+    allocation.size = requirements.size;
+
+    //Aligned on its size, the node covers the alignment
+    VkDeviceSize nodeSize = MIN_NODE_SIZE;
+
+    while(nodeSize < requirements.size || nodeSize < requirements.alignment)
+    {
+        nodeSize <<= 1;
+        allocation.order++;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryStats& stats = stats_[allocation.memoryType];
+
+    if(nodeSize > blockSizes_[allocation.memoryType])
+    {
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = requirements.size;
+        allocInfo.memoryTypeIndex = allocation.memoryType;
+
+        if(vkAllocateMemory(pCore_->getDevice(), &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate dedicated memory!");
+        }
+
+        if(isHostVisible(allocation.memoryType))
+        {
+            vkMapMemory(pCore_->getDevice(), allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.pMapped);
+        }
+
+        stats.dedicatedCount++;
+        stats.allocationCount++;
+        stats.reservedBytes += requirements.size;
+        stats.allocatedBytes += requirements.size;
+        stats.usedBytes += requirements.size;
+        return allocation;
+    }
+
+    bool isSeparated = isOptimalImage && separateOptimalImages_;
+    bool isAllocated = false;
+
+    for(const std::unique_ptr<MemoryBlock>& pBlock : blocks_)
+    {
+        if(pBlock->memoryType == allocation.memoryType && pBlock->isOptimalImage == isSeparated &&
+                allocateFromBlock(*pBlock, allocation.order, allocation))
+        {
+            isAllocated = true;
+            break;
+        }
+    }
+
+    if(!isAllocated)
+    {
+        allocateFromBlock(createBlock(allocation.memoryType, isSeparated), allocation.order, allocation);
+    }
+
+    stats.allocationCount++;
+    stats.allocatedBytes += nodeSize;
+    stats.usedBytes += requirements.size;
+    return allocation;
+}
+
+void MemoryAllocator::free(MemoryAllocation& allocation)
+{
+    if(allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryStats& stats = stats_[allocation.memoryType];
+    stats.allocationCount--;
+    stats.usedBytes -= allocation.size;
+
+    if(!allocation.pBlock)
+    {
+        vkFreeMemory(pCore_->getDevice(), allocation.memory, nullptr);
+        stats.dedicatedCount--;
+        stats.reservedBytes -= allocation.size;
+        stats.allocatedBytes -= allocation.size;
+        allocation = MemoryAllocation();
+        return;
+    }
+
+    MemoryBlock& block = *allocation.pBlock;
+    VkDeviceSize offset = allocation.offset;
+    uint32_t order = allocation.order;
+    stats.allocatedBytes -= MIN_NODE_SIZE << order;
+
+    //Merged with its buddy as long as the buddy is free
+    while(order < block.maxOrder)
+    {
+        VkDeviceSize buddyOffset = offset ^ (MIN_NODE_SIZE << order);
+        auto itBuddy = block.freeNodes[order].find(buddyOffset);
+
+        if(itBuddy == block.freeNodes[order].end())
+        {
+            break;
+        }
+
+        block.freeNodes[order].erase(itBuddy);
+        offset = std::min(offset, buddyOffset);
+        order++;
+    }
+
+    block.freeNodes[order].insert(offset);
+    block.allocationCount--;
+    allocation = MemoryAllocation();
+
+    if(block.allocationCount == 0)
+    {
+        releaseEmptyBlock(block);
+    }
+}
+
+void MemoryAllocator::releaseEmptyBlock(MemoryBlock& block)
+{
+    //The last block of a kind is kept, a model replaced by another would allocate it again
+    size_t sameKindCount = 0;
+
+    for(const std::unique_ptr<MemoryBlock>& pBlock : blocks_)
+    {
+        if(pBlock->memoryType == block.memoryType && pBlock->isOptimalImage == block.isOptimalImage)
+        {
+            sameKindCount++;
+        }
+    }
+
+    if(sameKindCount < 2)
+    {
+        return;
+    }
+
+    for(auto itBlock = blocks_.begin(); itBlock != blocks_.end(); itBlock++)
+    {
+        if(itBlock->get() == &block)
+        {
+            stats_[block.memoryType].blockCount--;
+            stats_[block.memoryType].reservedBytes -= blockSizes_[block.memoryType];
+            vkFreeMemory(pCore_->getDevice(), block.memory, nullptr);
+            blocks_.erase(itBlock);
+            return;
+        }
+    }
+}
+
+MemoryStats MemoryAllocator::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryStats totals;
+
+    for(const MemoryStats& stats : stats_)
+    {
+        totals.blockCount += stats.blockCount;
+        totals.dedicatedCount += stats.dedicatedCount;
+        totals.allocationCount += stats.allocationCount;
+        totals.reservedBytes += stats.reservedBytes;
+        totals.allocatedBytes += stats.allocatedBytes;
+        totals.usedBytes += stats.usedBytes;
+    }
+
+    return totals;
+}
+
+void MemoryAllocator::logStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for(size_t idxType = 0; idxType < stats_.size(); idxType++)
+    {
+        const MemoryStats& stats = stats_[idxType];
+
+        if(stats.blockCount == 0 && stats.dedicatedCount == 0)
+        {
+            continue;
+        }
+
+        PLOGI << "Memory type " << idxType << " : " << stats.allocationCount << " allocation(s) in "
+              << stats.blockCount << " block(s) and " << stats.dedicatedCount << " dedicated, "
+              << stats.usedBytes << " bytes used, " << stats.allocatedBytes << " allocated, "
+              << stats.reservedBytes << " reserved" << '\n';
+    }
+}
+
+}
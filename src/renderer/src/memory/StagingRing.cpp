@@ -0,0 +1,242 @@
+#include "renderer/memory/StagingRing.h"
+#include "renderer/VulkanCore.h"
+#include <plog/Log.h>
+
+namespace renderer
+{
+
+constexpr VkDeviceSize StagingRing::INITIAL_SIZE;
+constexpr VkDeviceSize StagingRing::DEFAULT_ALIGNMENT;
+
+StagingRing::StagingRing(const VulkanCore* pCore):
+    VkElement(pCore)
+{
+}
+
+StagingRing::~StagingRing()
+{
+    if(isCreated_)
+    {
+        destroy();
+    }
+}
+
+void StagingRing::create()
+{
+    createBuffer(INITIAL_SIZE);
+    isCreated_ = true;
+}
+
+void StagingRing::destroy()
+{
+    if(!isCreated_)
+    {
+        return;
+    }
+
+    while(!batches_.empty())
+    {
+        releaseOldestBatch(true);
+    }
+
+    for(StagingBuffer& buffer : retiredBuffers_)
+    {
+        destroyBuffer(buffer);
+    }
+
+    for(VkFence fence : freeFences_)
+    {
+        vkDestroyFence(pCore_->getDevice(), fence, nullptr);
+    }
+
+    retiredBuffers_.clear();
+    freeFences_.clear();
+    destroyBuffer(current_);
+    head_ = 0;
+    usedSize_ = 0;
+    unsubmittedSize_ = 0;
+    isCreated_ = false;
+}
+
+void StagingRing::createBuffer(VkDeviceSize capacity)
+{
+    pCore_->getUtils().createBuffer(capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                    current_.buffer, current_.memory);
+    capacity_ = capacity;
+    PLOGD << "Staging ring of " << capacity << " bytes created" << '\n';
+}
+
+void StagingRing::destroyBuffer(StagingBuffer& buffer)
+{
+    pCore_->getUtils().destroyBuffer(buffer.buffer, buffer.memory);
+    buffer.buffer = VK_NULL_HANDLE;
+}
+
+bool StagingRing::releaseOldestBatch(bool wait)
+{
+    Batch& batch = batches_.front();
+
+    if(wait)
+    {
+        vkWaitForFences(pCore_->getDevice(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    }
+    else if(vkGetFenceStatus(pCore_->getDevice(), batch.fence) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    vkResetFences(pCore_->getDevice(), 1, &batch.fence);
+    freeFences_.push_back(batch.fence);
+    usedSize_ -= batch.size;
+
+    for(StagingBuffer& buffer : batch.retiredBuffers)
+    {
+        destroyBuffer(buffer);
+    }
+
+    if(batch.commandBuffer != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(pCore_->getDevice(), batch.commandPool, 1, &batch.commandBuffer);
+    }
+
+    batches_.pop_front();
+
+    //Nothing is used anymore, the next ranges start from the beginning without wrapping
+    if(usedSize_ == 0)
+    {
+        head_ = 0;
+    }
+
+    return true;
+}
+
+StagingRange StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    while(!batches_.empty() && releaseOldestBatch(false))
+    {
+    }
+
+    VkDeviceSize offset;
+    VkDeviceSize padding;
+
+    while(true)
+    {
+        offset = (head_ + alignment - 1) & ~(alignment - 1);
+
+        //The end of the buffer is skipped rather than splitting the range
+        if(offset + size > capacity_)
+        {
+            offset = 0;
+        }
+
+        padding = offset >= head_ ? offset - head_ : capacity_ - head_;
+
+        //The free bytes follow head_, up to the oldest range still used
+        if(padding + size <= capacity_ - usedSize_)
+        {
+            break;
+        }
+
+        if(!batches_.empty())
+        {
+            releaseOldestBatch(true);
+            continue;
+        }
+
+        //Too large or full of unsubmitted ranges : the ranges given stay in the previous buffer
+        VkDeviceSize capacity = capacity_ * 2;
+
+        while(capacity < size + alignment)
+        {
+            capacity *= 2;
+        }
+
+        if(unsubmittedSize_ == 0)
+        {
+            destroyBuffer(current_);
+        }
+        else
+        {
+            retiredBuffers_.push_back(current_);
+        }
+
+        createBuffer(capacity);
+        head_ = 0;
+        usedSize_ = 0;
+        unsubmittedSize_ = 0;
+    }
+
+    head_ = offset + size;
+    usedSize_ += padding + size;
+    unsubmittedSize_ += padding + size;
+
+    StagingRange range;
+    range.buffer = current_.buffer;
+    range.offset = offset;
+    range.size = size;
+    range.pMapped = static_cast<char*>(current_.memory.pMapped) + offset;
+    return range;
+}
+
+VkFence StagingRing::endBatch(VkCommandPool commandPool, VkCommandBuffer commandBuffer)
+{
+    VkFence fence;
+
+    if(freeFences_.empty())
+    {
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        if(vkCreateFence(pCore_->getDevice(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create staging fence!");
+        }
+    }
+    else
+    {
+        fence = freeFences_.back();
+        freeFences_.pop_back();
+    }
+
+    Batch batch;
+    batch.id = ++lastBatchId_;
+    batch.fence = fence;
+    batch.size = unsubmittedSize_;
+    batch.retiredBuffers.swap(retiredBuffers_);
+    batch.commandPool = commandPool;
+    batch.commandBuffer = commandBuffer;
+    batches_.push_back(std::move(batch));
+    unsubmittedSize_ = 0;
+    return fence;
+}
+
+uint64_t StagingRing::getLastBatchId() const
+{
+    return lastBatchId_;
+}
+
+void StagingRing::waitForBatch(uint64_t batchId)
+{
+    while(!batches_.empty() && batches_.front().id <= batchId)
+    {
+        releaseOldestBatch(true);
+    }
+}
+
+bool StagingRing::isBatchComplete(uint64_t batchId)
+{
+    while(!batches_.empty() && batches_.front().id <= batchId && releaseOldestBatch(false))
+    {
+    }
+
+    //The batches are released in order, the ones left are more recent
+    return batches_.empty() || batches_.front().id > batchId;
+}
+
+VkDeviceSize StagingRing::getCapacity() const
+{
+    return capacity_;
+}
+
+}
@@ -1,4 +1,5 @@
 #include "renderer/texture/MaterialTexture.h"
+#include "renderer/UploadBatch.h"
 #include "renderer/VulkanCore.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -28,8 +29,18 @@ MaterialTexture::MaterialTexture(const renderer::VulkanCore* pCore, const std::s
 
 }
 
-void MaterialTexture::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth,
-                                      int32_t texHeight, uint32_t mipLevels)
+MaterialTexture::MaterialTexture(const VulkanCore* pCore, std::vector<unsigned char> pixels, uint32_t width,
+                                 uint32_t height, const VkFormat& format):
+    Texture2D(pCore, format),
+    pixels_(std::move(pixels)),
+    width_(width),
+    height_(height)
+{
+
+}
+
+void MaterialTexture::generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat,
+                                      int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 {
     VkFormatProperties formatProperties;
     vkGetPhysicalDeviceFormatProperties(pCore_->getPhysicalDevice(), imageFormat, &formatProperties);
@@ -39,8 +50,6 @@ void MaterialTexture::generateMipmaps(VkImage image, VkFormat imageFormat, int32
         throw std::runtime_error("Texture Image format does not support linear blitting");
     }
 
-    VkCommandBuffer commandBuffer = pCore_->getUtils().beginSingleTimeCommands(false);
-
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -123,8 +132,6 @@ void MaterialTexture::generateMipmaps(VkImage image, VkFormat imageFormat, int32
                          0, nullptr,
                          0, nullptr,
                          1, &barrier);
-
-    pCore_->getUtils().endSingleTimeCommands(commandBuffer, false);
 }
 
 
@@ -159,47 +166,58 @@ void MaterialTexture::createSampler()
 
 void MaterialTexture::createImage()
 {
+    if(!pixels_.empty())
+    {
+        uploadPixels(pixels_.data(), static_cast<int32_t>(width_), static_cast<int32_t>(height_));
+        std::vector<unsigned char>().swap(pixels_);
+        return;
+    }
 
     int texWidth, texHeight, texChannels;
     stbi_uc* pixels = stbi_load(path_.data(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-    mipLevels_ = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
     if(!pixels)
     {
         throw std::runtime_error("failed to load texture image!");
     }
 
-    mipLevels_ = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-
-    VkBuffer stageBuffer;
-    VkDeviceMemory stageBufferMemory;
+    uploadPixels(pixels, texWidth, texHeight);
+    stbi_image_free(pixels);
+}
 
-    pCore_->getUtils().createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stageBuffer,
-                                    stageBufferMemory);
-    void* pData;
-    vkMapMemory(pCore_->getDevice(), stageBufferMemory, 0, imageSize, 0, &pData);
-    memcpy(pData, pixels, imageSize);
-    vkUnmapMemory(pCore_->getDevice(), stageBufferMemory);
+void MaterialTexture::uploadPixels(const unsigned char* pPixels, int32_t texWidth, int32_t texHeight)
+{
+    mipLevels_ = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
     pCore_->getUtils().createImage(static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight),
                                    mipLevels_, VK_SAMPLE_COUNT_1_BIT, format_, VK_IMAGE_TILING_OPTIMAL,
                                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_, imageMemory_);
-    pCore_->getUtils().transitionImageLayout(image_, format_, VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels_);
-    //Copy the content of a VkBuffer into a VkImage format
-    pCore_->getUtils().copyBufferToImage(stageBuffer, image_,
-                                         static_cast<uint32_t>(static_cast<uint32_t>(texWidth)),
-                                         static_cast<uint32_t>(static_cast<uint32_t>(texHeight)));
-    //Transition the layout for shader ability to read it
-    //pCore_->getUtils().transitionImageLayout(image_, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
-    generateMipmaps(image_, format_, texWidth, texHeight, mipLevels_);
-
-    vkDestroyBuffer(pCore_->getDevice(), stageBuffer, nullptr);
-    vkFreeMemory(pCore_->getDevice(), stageBufferMemory, nullptr);
-    stbi_image_free(pixels);
+
+    //The transition, the copy and the blits of the mipmaps share one submission on the graphics queue. It is
+    //not waited for : the draws sampling the texture are submitted after it on the same queue
+    UploadBatch batch(pCore_, false);
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image_;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipLevels_;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    batch.pipelineBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, barrier);
+
+    batch.copyToImage(pPixels, image_, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    generateMipmaps(batch.getCommandBuffer(), image_, format_, texWidth, texHeight, mipLevels_);
+    batch.submitAsync();
+
 }
 
 
@@ -218,7 +236,12 @@ void MaterialTexture::create()
 
 void MaterialTexture::destroy()
 {
-    vkDestroySampler(pCore_->getDevice(), sampler_, nullptr);
+    //A texture shared by several materials may be destroyed more than once
+    if(isCreated_)
+    {
+        vkDestroySampler(pCore_->getDevice(), sampler_, nullptr);
+    }
+
     Texture2D::destroy();
 }
 
@@ -29,8 +29,8 @@ void Texture2D::destroy()
     if(isCreated_)
     {
         vkDestroyImageView(pCore_->getDevice(), imageView_, nullptr);
-        vkDestroyImage(pCore_->getDevice(), image_, nullptr);
-        vkFreeMemory(pCore_->getDevice(), imageMemory_, nullptr);
+        pCore_->getUtils().destroyImage(image_, imageMemory_);
+        isCreated_ = false;
     }
 }
 
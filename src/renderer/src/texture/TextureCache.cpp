@@ -0,0 +1,205 @@
+#include "renderer/texture/TextureCache.h"
+#include "renderer/VulkanCore.h"
+#include "loader/MeshCache.h"
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <stb_image.h>
+
+namespace renderer
+{
+
+TextureCache::TextureCache(const VulkanCore* pCore):
+    pCore_(pCore)
+{
+
+}
+
+TextureCache::~TextureCache()
+{
+
+}
+
+std::string TextureCache::getCanonicalPath(const std::string& path)
+{
+#ifdef WIN32_
+    char canonicalPath[_MAX_PATH];
+
+    if(_fullpath(canonicalPath, path.c_str(), _MAX_PATH) != nullptr)
+    {
+        return canonicalPath;
+    }
+
+#else
+    char canonicalPath[PATH_MAX];
+
+    //Resolves the symbolic links and the "..", fails if the file doesn't exist
+    if(realpath(path.c_str(), canonicalPath) != nullptr)
+    {
+        return canonicalPath;
+    }
+
+#endif
+    return path;
+}
+
+std::shared_ptr<TextureCache::DecodedImage> TextureCache::decode(const std::string& canonicalPath)
+{
+    std::shared_ptr<DecodedImage> pImage = std::make_shared<DecodedImage>();
+    std::ifstream file(canonicalPath, std::ios::binary | std::ios::ate);
+
+    if(!file.is_open())
+    {
+        PLOGW << "Can't open the texture : " << canonicalPath << '\n';
+        return pImage;
+    }
+
+    std::vector<char> content(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(content.data(), content.size());
+
+    //The same image saved under several names is decoded once
+    uint64_t contentHash = MeshCache::hashContent(content.data(), content.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itOwner = contentOwners_.emplace(contentHash, canonicalPath).first;
+
+        if(itOwner->second != canonicalPath)
+        {
+            pImage->sameContentAs = itOwner->second;
+            return pImage;
+        }
+    }
+
+    int width, height, channels;
+    stbi_uc* pPixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(content.data()),
+                       static_cast<int>(content.size()), &width, &height, &channels, STBI_rgb_alpha);
+
+    if(pPixels == nullptr)
+    {
+        PLOGW << "Can't decode the texture " << canonicalPath << " : " << stbi_failure_reason() << '\n';
+        return pImage;
+    }
+
+    pImage->pixels.assign(pPixels, pPixels + static_cast<size_t>(width) * height * 4);
+    pImage->width = static_cast<uint32_t>(width);
+    pImage->height = static_cast<uint32_t>(height);
+    stbi_image_free(pPixels);
+
+    return pImage;
+}
+
+std::shared_future<std::shared_ptr<TextureCache::DecodedImage>> TextureCache::enqueueDecode(
+            const std::string& canonicalPath)
+{
+    std::shared_future<std::shared_ptr<DecodedImage>> pending = decodePool_.enqueue([this, canonicalPath]()
+    {
+        return decode(canonicalPath);
+    }).share();
+
+    pendingImages_[canonicalPath] = pending;
+    return pending;
+}
+
+void TextureCache::prefetch(const std::string& path)
+{
+    if(path.empty())
+    {
+        return;
+    }
+
+    std::string canonicalPath = getCanonicalPath(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if(textures_.count(canonicalPath) == 0 && pendingImages_.count(canonicalPath) == 0)
+    {
+        enqueueDecode(canonicalPath);
+    }
+}
+
+std::shared_ptr<MaterialTexture> TextureCache::getTexture(const std::string& path)
+{
+    if(path.empty())
+    {
+        return nullptr;
+    }
+
+    std::string canonicalPath = getCanonicalPath(path);
+    std::shared_future<std::shared_ptr<DecodedImage>> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itTexture = textures_.find(canonicalPath);
+
+        if(itTexture != textures_.end())
+        {
+            return itTexture->second;
+        }
+
+        auto itPending = pendingImages_.find(canonicalPath);
+        pending = itPending != pendingImages_.end() ? itPending->second : enqueueDecode(canonicalPath);
+    }
+
+    //Usually decoded already, the decoding started when the loader gave the mesh
+    std::shared_ptr<DecodedImage> pImage = pending.get();
+    std::shared_ptr<MaterialTexture> pTexture;
+
+    if(!pImage->sameContentAs.empty())
+    {
+        pTexture = getTexture(pImage->sameContentAs);
+        PLOGD << canonicalPath << " shares the texture of " << pImage->sameContentAs << '\n';
+    }
+    else if(!pImage->pixels.empty())
+    {
+        pTexture = std::make_shared<MaterialTexture>(pCore_, std::move(pImage->pixels), pImage->width,
+                   pImage->height, VK_FORMAT_R8G8B8A8_UNORM);
+        pTexture->create();
+        PLOGD << "Texture uploaded : " << canonicalPath << " (" << pImage->width << "x" << pImage->height << ")"
+              << '\n';
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    textures_[canonicalPath] = pTexture;
+    pendingImages_.erase(canonicalPath);
+
+    return pTexture;
+}
+
+std::shared_ptr<MaterialTexture> TextureCache::getWhiteTexture()
+{
+    if(!pWhiteTexture_)
+    {
+        pWhiteTexture_ = std::make_shared<MaterialTexture>(pCore_, std::vector<unsigned char>(4, 255), 1, 1,
+                         VK_FORMAT_R8G8B8A8_UNORM);
+        pWhiteTexture_->create();
+    }
+
+    return pWhiteTexture_;
+}
+
+void TextureCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    //The images still decoding are dropped once done, nothing waits for them anymore
+    for(auto& texture : textures_)
+    {
+        if(texture.second)
+        {
+            texture.second->destroy();
+        }
+    }
+
+    if(pWhiteTexture_)
+    {
+        pWhiteTexture_->destroy();
+        pWhiteTexture_.reset();
+    }
+
+    textures_.clear();
+    pendingImages_.clear();
+    contentOwners_.clear();
+}
+
+}